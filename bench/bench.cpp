@@ -0,0 +1,1175 @@
+// Headless benchmarks for the lesson scenes and load paths
+// Runs under the dummy video driver and the software renderer, prints JSON,
+// and optionally compares against a stored baseline.
+
+#include "SDL.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "SDL_image.h"
+#include "SDL_ttf.h"
+#include"LTexture.h"
+#include"LHandle.h"
+#include"LSurfacePool.h"
+#include"LMemoryTracker.h"
+#include"LStartupTrace.h"
+#include"LJobSystem.h"
+#include"LAssetArchive.h"
+#include"LBatchReader.h"
+#include"LBitmap.h"
+#include"LUploadScheduler.h"
+#include"LTiledImage.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#define chdir _chdir
+#define getcwd _getcwd
+#define mkdir(path, mode) _mkdir(path)
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+//Lesson code from main.cpp, built with SDLTEST_NO_MAIN
+bool init();
+bool initParallel();
+void close();
+bool loadMedia();
+bool loadMedia9();
+bool loadMedia10();
+bool loadMedia11();
+SDL_Texture* lazyFoo_loadTexture(std::string path, SDL_Renderer* ren);
+SDL_Texture* loadTexture(const std::string& file, SDL_Renderer* ren);
+SDL_Surface* loadSurface(std::string path);
+SDL_Texture* renderText(const char* message, const char* fontFile, SDL_Color color, int fontSize, SDL_Renderer* renderer);
+void DrawLession8();
+void DrawLession9();
+void DrawLession10();
+void DrawLession11();
+void DrawLession12(SDL_Renderer* render, Uint8 r, Uint8 g, Uint8 b);
+
+extern LRendererHandle gRenderer;
+
+//Timings of one benchmark, in microseconds
+struct BenchResult
+{
+	std::string name;
+	int iterations;
+	double mean;
+	double p50;
+	double p99;
+
+	//"us" for timings, anything else is a measurement the baseline thresholds do not apply to
+	const char* unit;
+};
+
+//Command line settings
+struct BenchOptions
+{
+	const char* videoDriver;
+	const char* renderDriver;
+	const char* assets;
+	const char* out;
+	const char* baseline;
+	const char* saveBaseline;
+	const char* filter;
+	const char* archive;
+	const char* pngDir;
+	const char* tiles;
+	bool parallelInit;
+	//Output paths made absolute before entering the asset directory
+	std::string paths[5];
+	int warmup;
+	int sceneIterations;
+	int loadIterations;
+	//Small PNGs for the batch read benchmark, 0 to skip it
+	int pngCount;
+	//Allowed slowdown over the baseline, in percent
+	double meanThreshold;
+	double p99Threshold;
+};
+
+typedef void (*BenchFunction)(void* userdata);
+
+//Times fn one call at a time after a warm up
+static BenchResult runBench(const BenchOptions& options, const char* name, int iterations, BenchFunction fn, void* userdata)
+{
+	for (int i = 0; i < options.warmup; ++i)
+	{
+		fn(userdata);
+	}
+
+	std::vector<double> samples(iterations);
+	double toMicroseconds = 1e6 / (double)SDL_GetPerformanceFrequency();
+	for (int i = 0; i < iterations; ++i)
+	{
+		Uint64 start = SDL_GetPerformanceCounter();
+		fn(userdata);
+		samples[i] = (SDL_GetPerformanceCounter() - start) * toMicroseconds;
+	}
+
+	BenchResult result;
+	result.name = name;
+	result.iterations = iterations;
+	result.unit = "us";
+	result.mean = 0.0;
+	for (int i = 0; i < iterations; ++i)
+	{
+		result.mean += samples[i];
+	}
+	result.mean /= iterations;
+
+	//Nearest rank percentiles
+	std::sort(samples.begin(), samples.end());
+	result.p50 = samples[(iterations - 1) / 2];
+	result.p99 = samples[(iterations * 99 + 99) / 100 - 1];
+
+	fprintf(stderr, "%-28s %7d iterations  mean %10.2f us  p50 %10.2f us  p99 %10.2f us\n",
+		name, iterations, result.mean, result.p50, result.p99);
+	return result;
+}
+
+//A result measured once, such as a cold load
+static BenchResult singleResult(const char* name, double microseconds)
+{
+	BenchResult result;
+	result.name = name;
+	result.iterations = 1;
+	result.mean = microseconds;
+	result.p50 = microseconds;
+	result.p99 = microseconds;
+	result.unit = "us";
+	fprintf(stderr, "%-28s %7d iterations  mean %10.2f us\n", name, 1, microseconds);
+	return result;
+}
+
+//A size or count rather than a time, such as resident kilobytes
+static BenchResult measureResult(const char* name, double value, const char* unit)
+{
+	BenchResult result;
+	result.name = name;
+	result.iterations = 1;
+	result.mean = value;
+	result.p50 = value;
+	result.p99 = value;
+	result.unit = unit;
+	fprintf(stderr, "%-28s %10.2f %s\n", name, value, unit);
+	return result;
+}
+
+//True without a filter, or when one of the result names contains it
+static bool matchesFilter(const BenchOptions& options, const char* const* names, size_t count)
+{
+	if (options.filter == NULL)
+	{
+		return true;
+	}
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (SDL_strstr(names[i], options.filter) != NULL)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void benchDrawLession8(void*)
+{
+	DrawLession8();
+}
+
+static void benchDrawLession9(void*)
+{
+	DrawLession9();
+}
+
+static void benchDrawLession10(void*)
+{
+	DrawLession10();
+}
+
+static void benchDrawLession11(void*)
+{
+	DrawLession11();
+}
+
+static void benchDrawLession12(void*)
+{
+	DrawLession12(gRenderer.get(), 0xFF, 0x80, 0x40);
+}
+
+//Every bundled asset, loaded by path from loose files or from the archive
+static const char* const ASSET_IMAGES[] =
+{
+	"res/background.bmp", "res/background.png", "res/dots.png", "res/full.png", "res/hello.bmp", "res/image.bmp",
+	"res/image.png", "res/lession7.png", "res/lession9_viewport.png", "res/lession10/background.png", "res/lession10/foo.png"
+};
+static const char* const ASSET_FONT = "sample.ttf";
+
+//Load paths below go through every asset image per call
+static void benchLazyFooLoadTexture(void*)
+{
+	for (size_t i = 0; i < SDL_arraysize(ASSET_IMAGES); ++i)
+	{
+		destroyTrackedTexture(lazyFoo_loadTexture(ASSET_IMAGES[i], gRenderer.get()));
+	}
+}
+
+static void benchLoadTexture(void*)
+{
+	for (size_t i = 0; i < SDL_arraysize(ASSET_IMAGES); ++i)
+	{
+		destroyTrackedTexture(loadTexture(ASSET_IMAGES[i], gRenderer.get()));
+	}
+}
+
+static void benchLTextureLoadFromFile(void* userdata)
+{
+	//Reloading frees the previous texture first
+	LTexture* texture = (LTexture*)userdata;
+	for (size_t i = 0; i < SDL_arraysize(ASSET_IMAGES); ++i)
+	{
+		texture->loadFromFile(gRenderer.get(), ASSET_IMAGES[i]);
+	}
+}
+
+static void benchLoadSurface(void*)
+{
+	for (size_t i = 0; i < SDL_arraysize(ASSET_IMAGES); ++i)
+	{
+		gSurfacePool.release(loadSurface(ASSET_IMAGES[i]));
+	}
+}
+
+static void benchRenderText(void*)
+{
+	SDL_Color color = { 0xFF, 0xFF, 0xFF, 0xFF };
+	destroyTrackedTexture(renderText("The quick brown fox jumps over the lazy dog", "sample.ttf", color, 32, gRenderer.get()));
+}
+
+static void benchAssetsLoose(void*)
+{
+	for (size_t i = 0; i < SDL_arraysize(ASSET_IMAGES); ++i)
+	{
+		SDL_FreeSurface(IMG_Load(ASSET_IMAGES[i]));
+	}
+	LFontHandle font(TTF_OpenFont(ASSET_FONT, 16));
+}
+
+static void benchAssetsArchive(void*)
+{
+	for (size_t i = 0; i < SDL_arraysize(ASSET_IMAGES); ++i)
+	{
+		SDL_FreeSurface(gAssetArchive.loadImage(ASSET_IMAGES[i]));
+	}
+	LFontHandle font(TTF_OpenFontRW(gAssetArchive.openEntry(ASSET_FONT), 1, 16));
+}
+
+//A scene that loads every asset image but draws only the first
+static void loadScene(std::vector<LTexture>& scene, bool lazy)
+{
+	LTexture::setLazy(lazy);
+	for (size_t i = 0; i < scene.size(); ++i)
+	{
+		scene[i].loadFromFile(gRenderer.get(), ASSET_IMAGES[i]);
+	}
+	LTexture::setLazy(false);
+	scene[0].render(gRenderer.get(), 0, 0);
+}
+
+static void benchSceneEager(void* userdata)
+{
+	loadScene(*(std::vector<LTexture>*)userdata, false);
+}
+
+static void benchSceneLazy(void* userdata)
+{
+	loadScene(*(std::vector<LTexture>*)userdata, true);
+}
+
+//Worst frame of a scene switch that loads every asset image several times over in its first frame
+//Frames continue until every upload has landed, each drawing a corner of every sprite or its placeholder
+static double sceneSwitchWorstUs(bool budgeted, int* frames)
+{
+	gUploadScheduler.setBudget(budgeted ? LUploadScheduler::DEFAULT_BYTES : 0, budgeted ? LUploadScheduler::DEFAULT_MICROSECONDS : 0);
+	std::vector<LTexture> sprites(4 * SDL_arraysize(ASSET_IMAGES));
+	SDL_Rect clip = { 0, 0, 16, 16 };
+	double toMicroseconds = 1e6 / (double)SDL_GetPerformanceFrequency();
+	double worst = 0.0;
+	*frames = 0;
+	for (int frame = 0; frame < 10000 && (frame == 0 || gUploadScheduler.getPendingCount() > 0); ++frame)
+	{
+		Uint64 start = SDL_GetPerformanceCounter();
+		if (frame == 0)
+		{
+			for (size_t i = 0; i < sprites.size(); ++i)
+			{
+				sprites[i].loadFromFile(gRenderer.get(), ASSET_IMAGES[i % SDL_arraysize(ASSET_IMAGES)]);
+			}
+		}
+		SDL_RenderClear(gRenderer.get());
+		for (size_t i = 0; i < sprites.size(); ++i)
+		{
+			sprites[i].render(gRenderer.get(), (int)(i % 32) * 20, (int)(i / 32) * 20, &clip);
+		}
+		gUploadScheduler.update(gRenderer.get());
+		SDL_RenderPresent(gRenderer.get());
+		worst = SDL_max(worst, (SDL_GetPerformanceCounter() - start) * toMicroseconds);
+		++*frames;
+	}
+	gUploadScheduler.setBudget(0, 0);
+	return worst;
+}
+
+//Texture memory of a scene, ARGB8888 like every LTexture upload
+static double sceneTextureKb(std::vector<LTexture>& scene)
+{
+	double bytes = 0.0;
+	for (size_t i = 0; i < scene.size(); ++i)
+	{
+		if (scene[i].isLoaded())
+		{
+			bytes += 4.0 * scene[i].getWidth() * scene[i].getHeight();
+		}
+	}
+	return bytes / 1024.0;
+}
+
+//Writes count small PNGs into dir once, later runs reuse them
+static bool makePngs(const char* dir, int count, std::vector<std::string>& paths)
+{
+	mkdir(dir, 0755);
+	LSurfaceHandle surface(SDL_CreateRGBSurfaceWithFormat(0, 16, 16, 32, SDL_PIXELFORMAT_RGBA32));
+	if (!surface)
+	{
+		return false;
+	}
+	for (int i = 0; i < count; ++i)
+	{
+		char path[1024];
+		SDL_snprintf(path, sizeof(path), "%s/%05d.png", dir, i);
+		paths.push_back(path);
+		SDL_RWops* existing = SDL_RWFromFile(path, "rb");
+		if (existing != NULL)
+		{
+			SDL_RWclose(existing);
+			continue;
+		}
+
+		//Different pixels per file so nothing compresses to the same bytes
+		Uint32* pixels = (Uint32*)surface.get()->pixels;
+		for (int p = 0; p < 16 * 16; ++p)
+		{
+			pixels[p] = (Uint32)(i * 2654435761u + p * 40503u);
+		}
+		if (IMG_SavePNG(surface.get(), path) != 0)
+		{
+			printf("Unable to write %s! SDL_image Error: %s\n", path, IMG_GetError());
+			return false;
+		}
+	}
+	return true;
+}
+
+//Drops the files from the page cache so the next pass reads the disk
+//Elsewhere than Linux the pass is only as cold as the OS cache allows
+static void evictFiles(const std::vector<std::string>& paths)
+{
+#if defined(__linux__)
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		int fd = open(paths[i].c_str(), O_RDONLY);
+		if (fd >= 0)
+		{
+			fdatasync(fd);
+			posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+			close(fd);
+		}
+	}
+#endif
+}
+
+//Read buffers handed to decode jobs as they land
+struct PngFile
+{
+	void* data;
+	size_t size;
+};
+
+struct PngPass
+{
+	std::vector<PngFile> files;
+	LJobCounter decoded;
+};
+
+static void loadPngJob(void* data)
+{
+	SDL_FreeSurface(IMG_Load((const char*)data));
+}
+
+static void decodePngJob(void* data)
+{
+	PngFile& file = *(PngFile*)data;
+	SDL_FreeSurface(IMG_LoadTyped_RW(SDL_RWFromConstMem(file.data, (int)file.size), 1, "png"));
+	SDL_free(file.data);
+}
+
+static void onPngRead(int index, void* data, size_t size, void* userdata)
+{
+	if (data == NULL)
+	{
+		return;
+	}
+	PngPass* pass = (PngPass*)userdata;
+	pass->files[index].data = data;
+	pass->files[index].size = size;
+	gJobSystem.run(decodePngJob, &pass->files[index], &pass->decoded);
+}
+
+//IMG_Load per file on this thread, IMG_Load per file as jobs, then the batch reader through io_uring and through jobs
+static void benchPngs(const BenchOptions& options, std::vector<BenchResult>& results)
+{
+	std::vector<std::string> paths;
+	if (!makePngs(options.pngDir, options.pngCount, paths))
+	{
+		return;
+	}
+	double toMicroseconds = 1e6 / (double)SDL_GetPerformanceFrequency();
+	PngPass pass;
+	pass.files.resize(paths.size());
+
+	evictFiles(paths);
+	Uint64 start = SDL_GetPerformanceCounter();
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		SDL_FreeSurface(IMG_Load(paths[i].c_str()));
+	}
+	results.push_back(singleResult("pngs_cold_IMG_Load", (SDL_GetPerformanceCounter() - start) * toMicroseconds));
+
+	evictFiles(paths);
+	start = SDL_GetPerformanceCounter();
+	SDL_AtomicSet(&pass.decoded.value, 0);
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		gJobSystem.run(loadPngJob, (void*)paths[i].c_str(), &pass.decoded);
+	}
+	gJobSystem.wait(&pass.decoded);
+	results.push_back(singleResult("pngs_cold_IMG_Load_jobs", (SDL_GetPerformanceCounter() - start) * toMicroseconds));
+
+	LBatchReader reader;
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		reader.add(paths[i]);
+	}
+	for (int ioUring = 1; ioUring >= 0; --ioUring)
+	{
+		evictFiles(paths);
+		reader.setIoUring(ioUring != 0);
+		start = SDL_GetPerformanceCounter();
+		SDL_AtomicSet(&pass.decoded.value, 0);
+		reader.readAll(onPngRead, &pass);
+		gJobSystem.wait(&pass.decoded);
+		double microseconds = (SDL_GetPerformanceCounter() - start) * toMicroseconds;
+		if (ioUring == 0 || reader.usedIoUring())
+		{
+			results.push_back(singleResult(ioUring != 0 ? "pngs_cold_batch_io_uring" : "pngs_cold_batch_jobs", microseconds));
+		}
+	}
+}
+
+//The bundled bitmaps, all bottom-up 24 bit
+static const char* const BMP_FILES[] = { "res/background.bmp", "res/hello.bmp", "res/image.bmp" };
+
+//Top-down copies of BMP_FILES, which LBitmap can map without touching a pixel
+static std::vector<std::string> gTopDownBmps;
+
+//Writes a top-down copy of every bundled bitmap into dir
+static bool makeTopDownBmps(const char* dir)
+{
+	mkdir(dir, 0755);
+	for (size_t i = 0; i < SDL_arraysize(BMP_FILES); ++i)
+	{
+		size_t size = 0;
+		Uint8* data = (Uint8*)SDL_LoadFile(BMP_FILES[i], &size);
+		if (data == NULL || size < 54)
+		{
+			SDL_free(data);
+			return false;
+		}
+		Uint32 offset = data[10] | (data[11] << 8) | (data[12] << 16) | ((Uint32)data[13] << 24);
+		Sint32 w = (Sint32)(data[18] | (data[19] << 8) | (data[20] << 16) | ((Uint32)data[21] << 24));
+		Sint32 h = (Sint32)(data[22] | (data[23] << 8) | (data[24] << 16) | ((Uint32)data[25] << 24));
+		int bits = data[28] | (data[29] << 8);
+		size_t pitch = ((w * bits + 31) / 32) * 4;
+		if (h <= 0 || offset + pitch * h > size)
+		{
+			SDL_free(data);
+			return false;
+		}
+
+		//Negative height, rows reversed
+		std::vector<Uint8> out(data, data + size);
+		Uint32 flipped = (Uint32)-h;
+		for (int b = 0; b < 4; ++b)
+		{
+			out[22 + b] = (Uint8)(flipped >> (b * 8));
+		}
+		for (Sint32 y = 0; y < h; ++y)
+		{
+			SDL_memcpy(&out[offset + pitch * y], data + offset + pitch * (h - 1 - y), pitch);
+		}
+		SDL_free(data);
+
+		std::string path = std::string(dir) + "/topdown_" + (SDL_strrchr(BMP_FILES[i], '/') + 1);
+		SDL_RWops* file = SDL_RWFromFile(path.c_str(), "wb");
+		bool written = file != NULL && SDL_RWwrite(file, out.data(), out.size(), 1) == 1;
+		if (file != NULL)
+		{
+			SDL_RWclose(file);
+		}
+		if (!written)
+		{
+			printf("Unable to write %s\n", path.c_str());
+			return false;
+		}
+		gTopDownBmps.push_back(path);
+	}
+	return true;
+}
+
+//Gradient with a checkerboard, enough detail that tiles do not compress to nothing
+static void tiledSource(int x, int y, int w, int h, Uint32* pixels, int pitch, void*)
+{
+	for (int row = 0; row < h; ++row)
+	{
+		for (int column = 0; column < w; ++column)
+		{
+			int px = x + column;
+			int py = y + row;
+			Uint32 blue = ((px >> 4) ^ (py >> 4)) & 1 ? 0xC0 : 0x40;
+			pixels[row * pitch + column] = 0xFF000000 | (((px >> 5) & 0xFF) << 16) | (((py >> 5) & 0xFF) << 8) | blue;
+		}
+	}
+}
+
+//Viewer state carried across the frames of the pan and zoom script
+struct TiledScript
+{
+	LTiledImage image;
+	int frame;
+	size_t peakBytes;
+};
+
+//One frame of a pass that zooms from the whole image to 2x and back while drifting across it
+static void benchTiles(void* userdata)
+{
+	TiledScript* script = (TiledScript*)userdata;
+	LTiledImage& image = script->image;
+	int w = 0;
+	int h = 0;
+	SDL_GetRendererOutputSize(gRenderer.get(), &w, &h);
+	double fit = SDL_min((double)w / image.getWidth(), (double)h / image.getHeight());
+	double t = script->frame++ * 0.01;
+	double zoom = fit * SDL_pow(2.0 / fit, 0.5 - 0.5 * SDL_cos(t));
+	double centerX = image.getWidth() * (0.5 + 0.35 * SDL_sin(t * 0.7));
+	double centerY = image.getHeight() * (0.5 + 0.35 * SDL_sin(t * 0.45));
+
+	SDL_Rect dst = { 0, 0, w, h };
+	SDL_RenderClear(gRenderer.get());
+	image.render(gRenderer.get(), centerX - w * 0.5 / zoom, centerY - h * 0.5 / zoom, zoom, &dst);
+	SDL_RenderPresent(gRenderer.get());
+	script->peakBytes = SDL_max(script->peakBytes, image.getResidentBytes());
+}
+
+//Frame times of the tiled viewer and its peak tile memory, on --tiles or a generated 40960x40960 image, the size the viewer targets
+static void benchTiledImage(const BenchOptions& options, std::vector<BenchResult>& results)
+{
+	TiledScript script;
+	script.frame = 0;
+	script.peakBytes = 0;
+	std::string path = options.tiles != NULL ? options.tiles : std::string(options.pngDir) + "/bench.til";
+	if (options.tiles == NULL && !script.image.open(path))
+	{
+		mkdir(options.pngDir, 0755);
+		LTiledImage::build(path, 40960, 40960, tiledSource, NULL);
+	}
+	if (!script.image.isOpen() && !script.image.open(path))
+	{
+		return;
+	}
+	results.push_back(runBench(options, "tiles pan zoom", options.sceneIterations, benchTiles, &script));
+	results.push_back(measureResult("tiles_cache_kb_peak", script.peakBytes / 1024.0, "kb"));
+}
+
+static void benchBmpLoadBMP(void*)
+{
+	for (size_t i = 0; i < SDL_arraysize(BMP_FILES); ++i)
+	{
+		SDL_FreeSurface(SDL_LoadBMP(BMP_FILES[i]));
+	}
+}
+
+static void benchBmpFlip(void*)
+{
+	LBitmap bitmap;
+	for (size_t i = 0; i < SDL_arraysize(BMP_FILES); ++i)
+	{
+		bitmap.loadFromFile(BMP_FILES[i]);
+	}
+}
+
+static void benchBmpMapped(void*)
+{
+	LBitmap bitmap;
+	for (size_t i = 0; i < gTopDownBmps.size(); ++i)
+	{
+		bitmap.loadFromFile(gTopDownBmps[i]);
+	}
+}
+
+//Reads every pixel the way an upload would
+static Uint32 touchPixels(SDL_Surface* surface)
+{
+	Uint32 sum = 0;
+	for (int y = 0; surface != NULL && y < surface->h; ++y)
+	{
+		const Uint8* row = (const Uint8*)surface->pixels + (size_t)y * surface->pitch;
+		for (int x = 0; x < surface->pitch; x += 64)
+		{
+			sum += row[x];
+		}
+	}
+	return sum;
+}
+
+//Resident set growth while 64 copies of every bitmap are loaded and read, in kilobytes
+static void benchBmpMemory(std::vector<BenchResult>& results)
+{
+	const int copies = 64;
+	const int count = copies * (int)SDL_arraysize(BMP_FILES);
+	Uint32 sum = 0;
+
+	size_t before = LSurfacePool::getResidentBytes();
+	std::vector<SDL_Surface*> surfaces(count);
+	for (int i = 0; i < count; ++i)
+	{
+		surfaces[i] = SDL_LoadBMP(BMP_FILES[i % SDL_arraysize(BMP_FILES)]);
+		sum += touchPixels(surfaces[i]);
+	}
+	size_t loaded = LSurfacePool::getResidentBytes();
+	for (int i = 0; i < count; ++i)
+	{
+		SDL_FreeSurface(surfaces[i]);
+	}
+	results.push_back(measureResult("bmp_rss_kb_SDL_LoadBMP", loaded > before ? (loaded - before) / 1024.0 : 0.0, "kb"));
+
+	const std::vector<std::string> flipPaths(BMP_FILES, BMP_FILES + SDL_arraysize(BMP_FILES));
+	const std::vector<std::string>* paths[2] = { &flipPaths, &gTopDownBmps };
+	const char* names[2] = { "bmp_rss_kb_LBitmap_flip", "bmp_rss_kb_LBitmap_mapped" };
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		before = LSurfacePool::getResidentBytes();
+		std::vector<LBitmap> bitmaps(count);
+		for (int i = 0; i < count; ++i)
+		{
+			bitmaps[i].loadFromFile((*paths[pass])[i % paths[pass]->size()]);
+			sum += touchPixels(bitmaps[i].getSurface());
+		}
+		loaded = LSurfacePool::getResidentBytes();
+		results.push_back(measureResult(names[pass], loaded > before ? (loaded - before) / 1024.0 : 0.0, "kb"));
+	}
+
+	//Keeps the reads from being optimized away
+	if (sum == 0xFFFFFFFF)
+	{
+		printf("\n");
+	}
+}
+
+static void emptyJob(void*)
+{
+}
+
+static void benchJobs(void*)
+{
+	//1000 empty jobs, so microseconds per iteration read as nanoseconds per job
+	LJobCounter counter;
+	SDL_AtomicSet(&counter.value, 0);
+	for (int i = 0; i < 1000; ++i)
+	{
+		gJobSystem.run(emptyJob, NULL, &counter);
+	}
+	gJobSystem.wait(&counter);
+}
+
+static void benchJobChain(void*)
+{
+	//1000 jobs that each wait on the one before, which covers the release in finish()
+	LJobCounter chain[1000];
+	for (int i = 0; i < 1000; ++i)
+	{
+		SDL_AtomicSet(&chain[i].value, 0);
+		gJobSystem.run(emptyJob, NULL, &chain[i], i > 0 ? &chain[i - 1] : NULL);
+	}
+	gJobSystem.wait(&chain[999]);
+}
+
+static std::string formatResults(const BenchOptions& options, const std::vector<BenchResult>& results)
+{
+	char line[512];
+	SDL_snprintf(line, sizeof(line), "{\n\"video_driver\": \"%s\",\n\"render_driver\": \"%s\",\n\"benchmarks\": [\n",
+		options.videoDriver, options.renderDriver);
+	std::string json = line;
+
+	//One benchmark per line, which is what readBaseline() expects
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchResult& result = results[i];
+		if (SDL_strcmp(result.unit, "us") == 0)
+		{
+			SDL_snprintf(line, sizeof(line), "{\"name\": \"%s\", \"iterations\": %d, \"mean_us\": %.3f, \"p50_us\": %.3f, \"p99_us\": %.3f}%s\n",
+				result.name.c_str(), result.iterations, result.mean, result.p50, result.p99, i + 1 < results.size() ? "," : "");
+		}
+		else
+		{
+			//No *_us fields, so readBaseline() skips it
+			SDL_snprintf(line, sizeof(line), "{\"name\": \"%s\", \"value\": %.3f, \"unit\": \"%s\"}%s\n",
+				result.name.c_str(), result.mean, result.unit, i + 1 < results.size() ? "," : "");
+		}
+		json += line;
+	}
+	json += "]\n}\n";
+	return json;
+}
+
+static bool writeFile(const char* path, const std::string& text)
+{
+	SDL_RWops* file = SDL_RWFromFile(path, "wb");
+	if (file == NULL)
+	{
+		printf("Unable to open %s! SDL Error: %s\n", path, SDL_GetError());
+		return false;
+	}
+	SDL_RWwrite(file, text.data(), 1, text.size());
+	SDL_RWclose(file);
+	return true;
+}
+
+//Reads a number following "key": on the line
+static bool readField(const char* line, const char* key, double* value)
+{
+	const char* found = SDL_strstr(line, key);
+	if (found == NULL)
+	{
+		return false;
+	}
+	found = SDL_strchr(found + SDL_strlen(key), ':');
+	if (found == NULL)
+	{
+		return false;
+	}
+	*value = SDL_strtod(found + 1, NULL);
+	return true;
+}
+
+//Parses the file written by formatResults()
+static bool readBaseline(const char* path, std::vector<BenchResult>& baseline)
+{
+	size_t size = 0;
+	char* text = (char*)SDL_LoadFile(path, &size);
+	if (text == NULL)
+	{
+		printf("Unable to read baseline %s! SDL Error: %s\n", path, SDL_GetError());
+		return false;
+	}
+
+	for (char* line = text; line != NULL && *line != '\0';)
+	{
+		char* end = SDL_strchr(line, '\n');
+		if (end != NULL)
+		{
+			*end = '\0';
+		}
+
+		const char* name = SDL_strstr(line, "\"name\": \"");
+		if (name != NULL)
+		{
+			name += SDL_strlen("\"name\": \"");
+			const char* nameEnd = SDL_strchr(name, '"');
+			double iterations = 0.0;
+			BenchResult result;
+			if (nameEnd != NULL && readField(line, "\"mean_us\"", &result.mean) && readField(line, "\"p50_us\"", &result.p50)
+				&& readField(line, "\"p99_us\"", &result.p99) && readField(line, "\"iterations\"", &iterations))
+			{
+				result.name.assign(name, nameEnd);
+				result.iterations = (int)iterations;
+				result.unit = "us";
+				baseline.push_back(result);
+			}
+		}
+		line = end != NULL ? end + 1 : NULL;
+	}
+
+	SDL_free(text);
+	return true;
+}
+
+//Returns the number of benchmarks slower than the thresholds allow
+static int compareBaseline(const BenchOptions& options, const std::vector<BenchResult>& results, const std::vector<BenchResult>& baseline)
+{
+	int regressions = 0;
+	fprintf(stderr, "\nAgainst %s (mean +%.0f%%, p99 +%.0f%% allowed):\n", options.baseline, options.meanThreshold, options.p99Threshold);
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchResult& result = results[i];
+		if (SDL_strcmp(result.unit, "us") != 0)
+		{
+			continue;
+		}
+		const BenchResult* base = NULL;
+		for (size_t j = 0; j < baseline.size(); ++j)
+		{
+			if (baseline[j].name == result.name)
+			{
+				base = &baseline[j];
+				break;
+			}
+		}
+		if (base == NULL || base->mean <= 0.0 || base->p99 <= 0.0)
+		{
+			fprintf(stderr, "%-28s not in baseline\n", result.name.c_str());
+			continue;
+		}
+
+		double meanChange = (result.mean / base->mean - 1.0) * 100.0;
+		double p99Change = (result.p99 / base->p99 - 1.0) * 100.0;
+		bool regressed = meanChange > options.meanThreshold || p99Change > options.p99Threshold;
+		fprintf(stderr, "%-28s mean %+7.1f%%  p99 %+7.1f%%  %s\n", result.name.c_str(), meanChange, p99Change, regressed ? "REGRESSION" : "ok");
+		if (regressed)
+		{
+			++regressions;
+		}
+	}
+	return regressions;
+}
+
+static void printUsage(const char* program)
+{
+	printf("Usage: %s [options]\n"
+		"  --video DRIVER          SDL video driver (default dummy)\n"
+		"  --render DRIVER         SDL render driver (default software)\n"
+		"  --assets DIR            directory holding res/ and sample.ttf (default .)\n"
+		"  --init serial|parallel  startup order, parallel decodes while the window opens (default serial)\n"
+		"  --archive FILE          also time every asset from FILE, packed by sdlPack, against loose files\n"
+		"  --png-count N           also time cold loads of N generated 16x16 PNGs, e.g. 5000 (default 0)\n"
+		"  --png-dir DIR           where generated PNGs, top-down BMPs and bench.til are written (default bench_pngs)\n"
+		"  --tiles FILE            tiled image, built by sdlTiles, for the viewer benchmark (default generated)\n"
+		"  --filter TEXT           only run benchmarks whose name contains TEXT\n"
+		"  --warmup N              untimed calls before each benchmark (default 10)\n"
+		"  --scene-iterations N    timed frames per scene (default 500)\n"
+		"  --load-iterations N     timed calls per load path (default 200)\n"
+		"  --out FILE              write JSON to FILE instead of stdout\n"
+		"  --baseline FILE         compare against a previous JSON result\n"
+		"  --save-baseline FILE    also write the results as a new baseline\n"
+		"  --threshold PERCENT     allowed mean slowdown (default 10)\n"
+		"  --p99-threshold PERCENT allowed p99 slowdown (default 25)\n", program);
+}
+
+static bool parseOptions(int argc, char* argv[], BenchOptions& options)
+{
+	options.videoDriver = "dummy";
+	options.renderDriver = "software";
+	options.assets = NULL;
+	options.out = NULL;
+	options.baseline = NULL;
+	options.saveBaseline = NULL;
+	options.filter = NULL;
+	options.archive = NULL;
+	options.pngDir = "bench_pngs";
+	options.tiles = NULL;
+	options.pngCount = 0;
+	options.parallelInit = false;
+	options.warmup = 10;
+	options.sceneIterations = 500;
+	options.loadIterations = 200;
+	options.meanThreshold = 10.0;
+	options.p99Threshold = 25.0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+		if (SDL_strcmp(arg, "--help") == 0)
+		{
+			return false;
+		}
+		if (value == NULL)
+		{
+			printf("Missing value for %s\n", arg);
+			return false;
+		}
+		++i;
+
+		if (SDL_strcmp(arg, "--video") == 0) options.videoDriver = value;
+		else if (SDL_strcmp(arg, "--render") == 0) options.renderDriver = value;
+		else if (SDL_strcmp(arg, "--assets") == 0) options.assets = value;
+		else if (SDL_strcmp(arg, "--init") == 0) options.parallelInit = SDL_strcmp(value, "parallel") == 0;
+		else if (SDL_strcmp(arg, "--archive") == 0) options.archive = value;
+		else if (SDL_strcmp(arg, "--png-count") == 0) options.pngCount = SDL_atoi(value);
+		else if (SDL_strcmp(arg, "--png-dir") == 0) options.pngDir = value;
+		else if (SDL_strcmp(arg, "--tiles") == 0) options.tiles = value;
+		else if (SDL_strcmp(arg, "--filter") == 0) options.filter = value;
+		else if (SDL_strcmp(arg, "--warmup") == 0) options.warmup = SDL_atoi(value);
+		else if (SDL_strcmp(arg, "--scene-iterations") == 0) options.sceneIterations = SDL_atoi(value);
+		else if (SDL_strcmp(arg, "--load-iterations") == 0) options.loadIterations = SDL_atoi(value);
+		else if (SDL_strcmp(arg, "--out") == 0) options.out = value;
+		else if (SDL_strcmp(arg, "--baseline") == 0) options.baseline = value;
+		else if (SDL_strcmp(arg, "--save-baseline") == 0) options.saveBaseline = value;
+		else if (SDL_strcmp(arg, "--threshold") == 0) options.meanThreshold = SDL_atof(value);
+		else if (SDL_strcmp(arg, "--p99-threshold") == 0) options.p99Threshold = SDL_atof(value);
+		else
+		{
+			printf("Unknown option %s\n", arg);
+			return false;
+		}
+	}
+
+	if (options.warmup < 0 || options.sceneIterations < 1 || options.loadIterations < 1 || options.pngCount < 0)
+	{
+		printf("Iteration counts must be positive\n");
+		return false;
+	}
+	return true;
+}
+
+//Anchors relative output and baseline paths to the starting directory
+static bool keepPaths(BenchOptions& options)
+{
+	char cwd[4096];
+	if (getcwd(cwd, sizeof(cwd)) == NULL)
+	{
+		printf("Unable to get the working directory\n");
+		return false;
+	}
+	const char** paths[5] = { &options.out, &options.baseline, &options.saveBaseline, &options.pngDir, &options.tiles };
+	for (int i = 0; i < 5; ++i)
+	{
+		const char* path = *paths[i];
+		if (path == NULL || path[0] == '/' || path[0] == '\\' || (path[0] != '\0' && path[1] == ':'))
+		{
+			continue;
+		}
+		options.paths[i] = std::string(cwd) + "/" + path;
+		*paths[i] = options.paths[i].c_str();
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	gStartupTrace.begin();
+
+	BenchOptions options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage(argv[0]);
+		return 2;
+	}
+	if (options.assets != NULL && !keepPaths(options))
+	{
+		return 2;
+	}
+	if (options.assets != NULL && chdir(options.assets) != 0)
+	{
+		printf("Unable to enter asset directory %s\n", options.assets);
+		return 2;
+	}
+
+	gJobSystem.start(SDL_GetCPUCount() - 1);
+
+	//Headless, and presenting must not wait for a display
+	SDL_setenv("SDL_VIDEODRIVER", options.videoDriver, 1);
+	SDL_SetHint(SDL_HINT_RENDER_DRIVER, options.renderDriver);
+	SDL_SetHint(SDL_HINT_RENDER_VSYNC, "0");
+
+	if (options.parallelInit ? !initParallel() : !init() || !loadMedia())
+	{
+		close();
+		return 1;
+	}
+	if (!loadMedia9() || !loadMedia10() || !loadMedia11())
+	{
+		close();
+		return 1;
+	}
+
+	struct BenchEntry
+	{
+		const char* name;
+		BenchFunction fn;
+		bool scene;
+	};
+	const BenchEntry entries[] =
+	{
+		{ "DrawLession8", benchDrawLession8, true },
+		{ "DrawLession9", benchDrawLession9, true },
+		{ "DrawLession10", benchDrawLession10, true },
+		{ "DrawLession11", benchDrawLession11, true },
+		{ "DrawLession12", benchDrawLession12, true },
+		{ "lazyFoo_loadTexture", benchLazyFooLoadTexture, false },
+		{ "loadTexture", benchLoadTexture, false },
+		{ "LTexture::loadFromFile", benchLTextureLoadFromFile, false },
+		{ "loadSurface", benchLoadSurface, false },
+		{ "renderText", benchRenderText, false },
+		{ "LJobSystem 1000 empty jobs", benchJobs, false },
+		{ "LJobSystem 1000 dependent jobs", benchJobChain, false }
+	};
+
+	LTexture texture;
+	std::vector<BenchResult> results;
+	for (size_t i = 0; i < SDL_arraysize(entries); ++i)
+	{
+		const BenchEntry& entry = entries[i];
+		if (!matchesFilter(options, &entry.name, 1))
+		{
+			continue;
+		}
+		int iterations = entry.scene ? options.sceneIterations : options.loadIterations;
+		results.push_back(runBench(options, entry.name, iterations, entry.fn, &texture));
+	}
+	texture.free();
+
+	//Loose files against the archive, opened only now so the entries above keep timing loose files
+	//Cold is the first pass in this process, archive open and mapping included
+	const char* const assetNames[] = { "assets_cold_loose", "assets_cold_archive", "assets loose", "assets archive" };
+	if (options.archive != NULL && matchesFilter(options, assetNames, SDL_arraysize(assetNames)))
+	{
+		double toMicroseconds = 1e6 / (double)SDL_GetPerformanceFrequency();
+		Uint64 start = SDL_GetPerformanceCounter();
+		benchAssetsLoose(NULL);
+		results.push_back(singleResult("assets_cold_loose", (SDL_GetPerformanceCounter() - start) * toMicroseconds));
+
+		start = SDL_GetPerformanceCounter();
+		bool opened = gAssetArchive.open(options.archive);
+		benchAssetsArchive(NULL);
+		results.push_back(singleResult("assets_cold_archive", (SDL_GetPerformanceCounter() - start) * toMicroseconds));
+
+		if (opened)
+		{
+			results.push_back(runBench(options, "assets loose", options.loadIterations, benchAssetsLoose, NULL));
+			results.push_back(runBench(options, "assets archive", options.loadIterations, benchAssetsArchive, NULL));
+		}
+		else
+		{
+			printf("Unable to open asset archive %s\n", options.archive);
+		}
+		gAssetArchive.close();
+	}
+
+	//Every asset loaded up front against decoding only the one drawn
+	const char* const sceneNames[] = { "scene eager", "scene_texture_kb_eager", "scene lazy", "scene_texture_kb_lazy" };
+	if (matchesFilter(options, sceneNames, SDL_arraysize(sceneNames)))
+	{
+		std::vector<LTexture> scene(SDL_arraysize(ASSET_IMAGES));
+		results.push_back(runBench(options, "scene eager", options.loadIterations, benchSceneEager, &scene));
+		results.push_back(measureResult("scene_texture_kb_eager", sceneTextureKb(scene), "kb"));
+		results.push_back(runBench(options, "scene lazy", options.loadIterations, benchSceneLazy, &scene));
+		results.push_back(measureResult("scene_texture_kb_lazy", sceneTextureKb(scene), "kb"));
+	}
+
+	//Scene switch uploading everything in its first frame against the per frame upload budget
+	const char* const switchNames[] = { "scene_switch_worst_frame_us_immediate", "scene_switch_worst_frame_us_budgeted", "scene_switch_frames_budgeted" };
+	if (matchesFilter(options, switchNames, SDL_arraysize(switchNames)))
+	{
+		int frames = 0;
+		results.push_back(singleResult("scene_switch_worst_frame_us_immediate", sceneSwitchWorstUs(false, &frames)));
+		results.push_back(singleResult("scene_switch_worst_frame_us_budgeted", sceneSwitchWorstUs(true, &frames)));
+		results.push_back(measureResult("scene_switch_frames_budgeted", frames, "frames"));
+	}
+
+	//Bitmaps through SDL_LoadBMP against LBitmap flipping bottom-up files and mapping top-down copies
+	const char* const bmpNames[] = { "bmp SDL_LoadBMP", "bmp LBitmap flip", "bmp LBitmap mapped",
+		"bmp_rss_kb_SDL_LoadBMP", "bmp_rss_kb_LBitmap_flip", "bmp_rss_kb_LBitmap_mapped" };
+	if (matchesFilter(options, bmpNames, SDL_arraysize(bmpNames)) && makeTopDownBmps(options.pngDir))
+	{
+		results.push_back(runBench(options, "bmp SDL_LoadBMP", options.loadIterations, benchBmpLoadBMP, NULL));
+		results.push_back(runBench(options, "bmp LBitmap flip", options.loadIterations, benchBmpFlip, NULL));
+		results.push_back(runBench(options, "bmp LBitmap mapped", options.loadIterations, benchBmpMapped, NULL));
+		benchBmpMemory(results);
+	}
+
+	//Pan and zoom over an image far larger than any texture, only tiles near the view decoded
+	const char* const tileNames[] = { "tiles pan zoom", "tiles_cache_kb_peak" };
+	if (matchesFilter(options, tileNames, SDL_arraysize(tileNames)))
+	{
+		benchTiledImage(options, results);
+	}
+
+	const char* const pngNames[] = { "pngs_cold_IMG_Load", "pngs_cold_IMG_Load_jobs", "pngs_cold_batch_io_uring", "pngs_cold_batch_jobs" };
+	if (options.pngCount > 0 && matchesFilter(options, pngNames, SDL_arraysize(pngNames)))
+	{
+		benchPngs(options, results);
+	}
+
+	//Startup up to the first scene's first present, tracked like any other result
+	if (gStartupTrace.getTimeToFirstPresent() > 0.0)
+	{
+		results.push_back(singleResult(options.parallelInit ? "time_to_first_present_parallel" : "time_to_first_present",
+			gStartupTrace.getTimeToFirstPresent() * 1000.0));
+	}
+
+	//Sections run when any of their results match, only the matching ones are kept
+	for (size_t i = 0; i < results.size();)
+	{
+		const char* name = results[i].name.c_str();
+		if (matchesFilter(options, &name, 1))
+		{
+			++i;
+		}
+		else
+		{
+			results.erase(results.begin() + i);
+		}
+	}
+
+	bool written = true;
+	std::string json = formatResults(options, results);
+	if (options.out != NULL)
+	{
+		written = writeFile(options.out, json);
+	}
+	else
+	{
+		fputs(json.c_str(), stdout);
+	}
+	if (options.saveBaseline != NULL)
+	{
+		written = writeFile(options.saveBaseline, json) && written;
+	}
+
+	int regressions = 0;
+	if (options.baseline != NULL)
+	{
+		std::vector<BenchResult> baseline;
+		if (!readBaseline(options.baseline, baseline))
+		{
+			written = false;
+		}
+		else
+		{
+			regressions = compareBaseline(options, results, baseline);
+		}
+	}
+
+	close();
+	if (regressions > 0)
+	{
+		fprintf(stderr, "%d benchmark(s) regressed\n", regressions);
+		return 1;
+	}
+	return written ? 0 : 1;
+}
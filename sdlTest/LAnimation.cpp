@@ -0,0 +1,230 @@
+#include"LAnimation.h"
+#include"LStartupTrace.h"
+
+#include <stdio.h>
+
+LAnimationSet::LAnimationSet()
+{
+}
+
+static Uint32 greatestCommonDivisor(Uint32 a, Uint32 b)
+{
+	while (b != 0)
+	{
+		Uint32 t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+bool LAnimationSet::loadFromFile(std::string path)
+{
+	LSTARTUP_PHASE(path.c_str());
+
+	//Get rid of preexisting sequences
+	free();
+
+	//Read the whole file
+	SDL_RWops* file = SDL_RWFromFile(path.c_str(), "rb");
+	if (file == NULL)
+	{
+		printf("Unable to open animation file %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+		return false;
+	}
+	std::string text((size_t)SDL_RWsize(file), '\0');
+	if (!text.empty())
+	{
+		SDL_RWread(file, &text[0], 1, text.size());
+	}
+	SDL_RWclose(file);
+
+	std::vector<Uint32> durations;
+	size_t lineStart = 0;
+	int lineNumber = 0;
+	while (lineStart < text.size())
+	{
+		size_t lineEnd = text.find('\n', lineStart);
+		if (lineEnd == std::string::npos)
+		{
+			lineEnd = text.size();
+		}
+		std::string line = text.substr(lineStart, lineEnd - lineStart);
+		lineStart = lineEnd + 1;
+		++lineNumber;
+
+		char name[64];
+		SDL_Rect clip;
+		unsigned int duration;
+		if (line.empty() || line[0] == '#' || line[0] == '\r')
+		{
+			continue;
+		}
+		else if (sscanf(line.c_str(), "animation %63s", name) == 1)
+		{
+			//Finish the previous sequence
+			if (!mSequences.empty())
+			{
+				buildTimeline((int)mSequences.size() - 1, durations);
+			}
+			Sequence sequence;
+			sequence.name = name;
+			sequence.firstClip = (int)mClips.size();
+			sequence.frameCount = 0;
+			sequence.duration = 0;
+			sequence.step = 1;
+			sequence.timeline = 0;
+			mSequences.push_back(sequence);
+			durations.clear();
+		}
+		else if (sscanf(line.c_str(), "frame %d %d %d %d %u", &clip.x, &clip.y, &clip.w, &clip.h, &duration) == 5
+			&& !mSequences.empty() && duration > 0)
+		{
+			mClips.push_back(clip);
+			durations.push_back(duration);
+			++mSequences.back().frameCount;
+		}
+		else
+		{
+			printf("Invalid animation line %d in %s\n", lineNumber, path.c_str());
+			free();
+			return false;
+		}
+	}
+	if (!mSequences.empty())
+	{
+		buildTimeline((int)mSequences.size() - 1, durations);
+	}
+
+	//Drop sequences without frames, they cannot be looked up
+	for (size_t i = 0; i < mSequences.size(); ++i)
+	{
+		if (mSequences[i].frameCount == 0)
+		{
+			printf("Animation %s in %s has no frames\n", mSequences[i].name.c_str(), path.c_str());
+			free();
+			return false;
+		}
+	}
+	return !mSequences.empty();
+}
+
+void LAnimationSet::buildTimeline(int index, const std::vector<Uint32>& durations)
+{
+	Sequence& sequence = mSequences[index];
+	if (durations.empty())
+	{
+		return;
+	}
+
+	//One timeline entry per common divisor of the frame durations
+	Uint32 step = durations[0];
+	Uint32 total = 0;
+	for (size_t i = 0; i < durations.size(); ++i)
+	{
+		step = greatestCommonDivisor(step, durations[i]);
+		total += durations[i];
+	}
+	sequence.duration = total;
+	sequence.step = step;
+	sequence.timeline = (int)mTimeline.size();
+	for (size_t i = 0; i < durations.size(); ++i)
+	{
+		mTimeline.insert(mTimeline.end(), durations[i] / step, (Uint16)(sequence.firstClip + i));
+	}
+}
+
+void LAnimationSet::free()
+{
+	mSequences.clear();
+	mClips.clear();
+	mTimeline.clear();
+}
+
+int LAnimationSet::find(const std::string& name) const
+{
+	for (size_t i = 0; i < mSequences.size(); ++i)
+	{
+		if (mSequences[i].name == name)
+		{
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+const SDL_Rect* LAnimationSet::getClips() const
+{
+	return mClips.empty() ? NULL : &mClips[0];
+}
+
+int LAnimationSet::getClipCount() const
+{
+	return (int)mClips.size();
+}
+
+int LAnimationSet::getFirstClip(int animation) const
+{
+	return mSequences[animation].firstClip;
+}
+
+int LAnimationSet::getFrameCount(int animation) const
+{
+	return mSequences[animation].frameCount;
+}
+
+int LAnimationSet::getAnimationCount() const
+{
+	return (int)mSequences.size();
+}
+
+LAnimator::LAnimator()
+{
+}
+
+void LAnimator::reserve(int instances)
+{
+	mAnimation.reserve(instances);
+	mTime.reserve(instances);
+	mCurrent.reserve(instances);
+}
+
+int LAnimator::add(const LAnimationSet& set, int animation, Uint32 start)
+{
+	mAnimation.push_back((Uint16)animation);
+	mTime.push_back(start);
+	mCurrent.push_back(set.getClipIndex(animation, start));
+	return (int)mAnimation.size() - 1;
+}
+
+void LAnimator::clear()
+{
+	mAnimation.clear();
+	mTime.clear();
+	mCurrent.clear();
+}
+
+void LAnimator::update(const LAnimationSet& set, Uint32 elapsed)
+{
+	int count = (int)mAnimation.size();
+	const Uint16* animation = count > 0 ? &mAnimation[0] : NULL;
+	Uint32* time = count > 0 ? &mTime[0] : NULL;
+	Uint16* current = count > 0 ? &mCurrent[0] : NULL;
+	for (int i = 0; i < count; ++i)
+	{
+		time[i] += elapsed;
+		current[i] = set.getClipIndex(animation[i], time[i]);
+	}
+}
+
+void LAnimator::play(const LAnimationSet& set, int instance, int animation)
+{
+	mAnimation[instance] = (Uint16)animation;
+	mTime[instance] = 0;
+	mCurrent[instance] = set.getClipIndex(animation, 0);
+}
+
+int LAnimator::getCount() const
+{
+	return (int)mAnimation.size();
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#ifndef LANIMATION_H
+#define LANIMATION_H
+
+#include <iostream>
+#include <vector>
+#include "SDL.h"
+
+//Clip sequences loaded from a metadata file with a precomputed frame timeline per sequence
+class LAnimationSet
+{
+public:
+	//Initializes variables
+	LAnimationSet();
+
+	//Loads sequences from a text file of "animation <name>" and "frame <x> <y> <w> <h> <ms>" lines
+	bool loadFromFile(std::string path);
+
+	//Deallocates sequences
+	void free();
+
+	//Finds a sequence by name, returns -1 if missing
+	int find(const std::string& name) const;
+
+	//Gets the clip shown time milliseconds into a sequence, looping
+	const SDL_Rect& getClip(int animation, Uint32 time) const
+	{
+		const Sequence& sequence = mSequences[animation];
+		return mClips[mTimeline[sequence.timeline + (time % sequence.duration) / sequence.step]];
+	}
+
+	//Gets the clip index into getClips() for the same lookup
+	Uint16 getClipIndex(int animation, Uint32 time) const
+	{
+		const Sequence& sequence = mSequences[animation];
+		return mTimeline[sequence.timeline + (time % sequence.duration) / sequence.step];
+	}
+
+	//Gets every clip of every sequence, sequences are stored contiguously
+	const SDL_Rect* getClips() const;
+	int getClipCount() const;
+
+	//Gets the first clip and frame count of a sequence
+	int getFirstClip(int animation) const;
+	int getFrameCount(int animation) const;
+
+	int getAnimationCount() const;
+
+private:
+	struct Sequence
+	{
+		std::string name;
+		int firstClip;
+		int frameCount;
+
+		//Loop length, timeline resolution and timeline offset in milliseconds
+		Uint32 duration;
+		Uint32 step;
+		int timeline;
+	};
+
+	//Builds the timeline of sequence number index from its frame durations
+	void buildTimeline(int index, const std::vector<Uint32>& durations);
+
+	std::vector<Sequence> mSequences;
+	std::vector<SDL_Rect> mClips;
+
+	//Clip index per timeline step for every sequence
+	std::vector<Uint16> mTimeline;
+};
+
+//Playback state for many sprites sharing one animation set
+class LAnimator
+{
+public:
+	//Initializes variables
+	LAnimator();
+
+	//Preallocates instance storage so adding instances does not allocate
+	void reserve(int instances);
+
+	//Adds a sprite playing the given sequence of set from start milliseconds, returns its handle
+	//Its clip is current right away, before the next update()
+	int add(const LAnimationSet& set, int animation, Uint32 start = 0);
+
+	//Removes all instances
+	void clear();
+
+	//Advances every instance and refreshes its current clip
+	void update(const LAnimationSet& set, Uint32 elapsed);
+
+	//Switches an instance to another sequence of set from its start, clip included
+	void play(const LAnimationSet& set, int instance, int animation);
+
+	//Gets the current clip index of an instance into the set's clips
+	Uint16 getClipIndex(int instance) const
+	{
+		return mCurrent[instance];
+	}
+
+	int getCount() const;
+
+private:
+	//Instance state as parallel arrays
+	std::vector<Uint16> mAnimation;
+	std::vector<Uint32> mTime;
+	std::vector<Uint16> mCurrent;
+};
+#endif
@@ -0,0 +1,338 @@
+#include"LAssetArchive.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include "SDL_image.h"
+
+LAssetArchive gAssetArchive;
+
+//Bumped whenever the layout changes
+static const char ARCHIVE_MAGIC[4] = { 'L', 'P', 'A', 'K' };
+static const Uint32 ARCHIVE_VERSION = 1;
+
+//Header fields at any alignment
+static Uint32 readBE32(const Uint8* data)
+{
+	return ((Uint32)data[0] << 24) | ((Uint32)data[1] << 16) | ((Uint32)data[2] << 8) | data[3];
+}
+
+static Uint32 readLE32(const Uint8* data)
+{
+	return ((Uint32)data[3] << 24) | ((Uint32)data[2] << 16) | ((Uint32)data[1] << 8) | data[0];
+}
+
+LAssetArchive::LAssetArchive()
+{
+	//Initialize
+	mEntries = NULL;
+	mNames = NULL;
+	mCount = 0;
+}
+
+LAssetArchive::~LAssetArchive()
+{
+	//Deallocate
+	close();
+}
+
+bool LAssetArchive::open(std::string path)
+{
+	close();
+
+	//Pages come in as entries are read
+	if (!mFile.open(path))
+	{
+		return false;
+	}
+	const Uint8* data = mFile.getData();
+	size_t size = mFile.getSize();
+	if (size < sizeof(Header))
+	{
+		printf("Asset archive %s is too small\n", path.c_str());
+		close();
+		return false;
+	}
+
+	//Check every offset once so lookups can trust them
+	const Header* header = (const Header*)data;
+	if (SDL_memcmp(header->magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 || header->version != ARCHIVE_VERSION)
+	{
+		printf("%s is not a version %u asset archive\n", path.c_str(), ARCHIVE_VERSION);
+		close();
+		return false;
+	}
+	Uint64 indexEnd = sizeof(Header) + (Uint64)header->count * sizeof(Entry);
+	if (indexEnd + header->namesSize > size)
+	{
+		printf("Asset archive %s has a truncated index\n", path.c_str());
+		close();
+		return false;
+	}
+	const Entry* entries = (const Entry*)(data + sizeof(Header));
+	for (Uint32 i = 0; i < header->count; ++i)
+	{
+		const Entry& entry = entries[i];
+		if (entry.offset > size || entry.size > size - entry.offset || entry.size > SDL_MAX_SINT32 ||
+			(Uint64)entry.nameOffset + entry.nameLength > header->namesSize || (i > 0 && entries[i - 1].hash > entry.hash))
+		{
+			printf("Asset archive %s has a bad entry %u\n", path.c_str(), i);
+			close();
+			return false;
+		}
+	}
+
+	mEntries = entries;
+	mNames = (const char*)(data + indexEnd);
+	mCount = header->count;
+	return true;
+}
+
+void LAssetArchive::close()
+{
+	mFile.close();
+	mEntries = NULL;
+	mNames = NULL;
+	mCount = 0;
+}
+
+bool LAssetArchive::isOpen()
+{
+	return mFile.isOpen();
+}
+
+std::string LAssetArchive::normalize(const std::string& path)
+{
+	std::string normalized = path;
+	std::replace(normalized.begin(), normalized.end(), '\\', '/');
+	while (normalized.compare(0, 2, "./") == 0)
+	{
+		normalized.erase(0, 2);
+	}
+	return normalized;
+}
+
+Uint64 LAssetArchive::hashPath(const std::string& normalized)
+{
+	//FNV-1a
+	Uint64 hash = 14695981039346656037ull;
+	for (size_t i = 0; i < normalized.size(); ++i)
+	{
+		hash ^= (Uint8)normalized[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+const LAssetArchive::Entry* LAssetArchive::find(const std::string& path)
+{
+	if (mCount == 0)
+	{
+		return NULL;
+	}
+
+	std::string normalized = normalize(path);
+	Uint64 hash = hashPath(normalized);
+	const Entry* end = mEntries + mCount;
+	const Entry* entry = std::lower_bound(mEntries, end, hash,
+		[](const Entry& entry, Uint64 hash) { return entry.hash < hash; });
+	for (; entry != end && entry->hash == hash; ++entry)
+	{
+		if (entry->nameLength == normalized.size() && SDL_memcmp(mNames + entry->nameOffset, normalized.data(), entry->nameLength) == 0)
+		{
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+bool LAssetArchive::contains(const std::string& path)
+{
+	return find(path) != NULL;
+}
+
+SDL_RWops* LAssetArchive::openEntry(const std::string& path)
+{
+	const Entry* entry = find(path);
+	if (entry == NULL)
+	{
+		return NULL;
+	}
+	return SDL_RWFromConstMem(mFile.getData() + entry->offset, (int)entry->size);
+}
+
+SDL_RWops* LAssetArchive::openFile(const std::string& path)
+{
+	SDL_RWops* file = openEntry(path);
+	return file != NULL ? file : SDL_RWFromFile(path.c_str(), "rb");
+}
+
+SDL_Surface* LAssetArchive::loadImage(const std::string& path)
+{
+	SDL_RWops* file = openFile(path);
+	if (file == NULL)
+	{
+		return NULL;
+	}
+
+	return IMG_LoadTyped_RW(file, 1, getImageType(path));
+}
+
+bool LAssetArchive::getImageSize(const std::string& path, int* w, int* h)
+{
+	SDL_RWops* file = openFile(path);
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	Uint8 header[26];
+	size_t length = SDL_RWread(file, header, 1, sizeof(header));
+	Sint64 width = 0;
+	Sint64 height = 0;
+	if (length >= 24 && SDL_memcmp(header, "\x89PNG\r\n\x1A\n", 8) == 0 && SDL_memcmp(header + 12, "IHDR", 4) == 0)
+	{
+		//First chunk is always IHDR, big endian
+		width = readBE32(header + 16);
+		height = readBE32(header + 20);
+	}
+	else if (length >= 26 && header[0] == 'B' && header[1] == 'M' && readLE32(header + 14) >= 40)
+	{
+		//Negative heights are top-down files, old OS/2 headers are left to the decoder
+		width = (Sint32)readLE32(header + 18);
+		height = (Sint32)readLE32(header + 22);
+		height = height < 0 ? -height : height;
+	}
+	else if (length >= 10 && SDL_memcmp(header, "GIF", 3) == 0)
+	{
+		width = header[6] | (header[7] << 8);
+		height = header[8] | (header[9] << 8);
+	}
+	else if (length >= 4 && header[0] == 0xFF && header[1] == 0xD8)
+	{
+		//Walk the segments up to the start of frame, past any metadata
+		Sint64 offset = 2;
+		Uint8 segment[9];
+		while (SDL_RWseek(file, offset, RW_SEEK_SET) == offset && SDL_RWread(file, segment, 1, 4) == 4 && segment[0] == 0xFF)
+		{
+			Uint8 marker = segment[1];
+			Sint64 segmentLength = (segment[2] << 8) | segment[3];
+			bool frame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+			if (frame)
+			{
+				if (SDL_RWread(file, segment + 4, 1, 5) == 5)
+				{
+					height = (segment[5] << 8) | segment[6];
+					width = (segment[7] << 8) | segment[8];
+				}
+				break;
+			}
+			if (segmentLength < 2)
+			{
+				break;
+			}
+			offset += 2 + segmentLength;
+		}
+	}
+	SDL_RWclose(file);
+
+	if (width <= 0 || height <= 0 || width > SDL_MAX_SINT32 || height > SDL_MAX_SINT32)
+	{
+		return false;
+	}
+	*w = (int)width;
+	*h = (int)height;
+	return true;
+}
+
+const char* LAssetArchive::getImageType(const std::string& path)
+{
+	size_t dot = path.find_last_of('.');
+	return dot != std::string::npos ? path.c_str() + dot + 1 : "";
+}
+
+bool LAssetArchive::pack(std::string path, const std::vector<std::string>& files)
+{
+	struct Source
+	{
+		std::string name;
+		void* data;
+		size_t size;
+		Entry entry;
+	};
+
+	//Read every file up front so the index can be sorted before anything is written
+	std::vector<Source> sources(files.size());
+	bool success = true;
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		Source& source = sources[i];
+		source.name = normalize(files[i]);
+		source.data = success ? SDL_LoadFile(files[i].c_str(), &source.size) : NULL;
+		if (success && source.data == NULL)
+		{
+			printf("Unable to read %s! SDL Error: %s\n", files[i].c_str(), SDL_GetError());
+			success = false;
+		}
+		source.entry.hash = hashPath(source.name);
+	}
+	std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b)
+		{ return a.entry.hash != b.entry.hash ? a.entry.hash < b.entry.hash : a.name < b.name; });
+
+	//Names follow the index, data follows the names
+	Header header;
+	SDL_memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+	header.version = ARCHIVE_VERSION;
+	header.count = (Uint32)sources.size();
+	header.namesSize = 0;
+	for (size_t i = 0; i < sources.size(); ++i)
+	{
+		sources[i].entry.nameOffset = header.namesSize;
+		sources[i].entry.nameLength = (Uint32)sources[i].name.size();
+		header.namesSize += sources[i].entry.nameLength;
+	}
+	Uint64 offset = sizeof(Header) + (Uint64)header.count * sizeof(Entry) + header.namesSize;
+	for (size_t i = 0; i < sources.size(); ++i)
+	{
+		offset = (offset + ALIGNMENT - 1) & ~(Uint64)(ALIGNMENT - 1);
+		sources[i].entry.offset = offset;
+		sources[i].entry.size = sources[i].size;
+		offset += sources[i].size;
+	}
+
+	SDL_RWops* file = success ? SDL_RWFromFile(path.c_str(), "wb") : NULL;
+	if (success && file == NULL)
+	{
+		printf("Unable to create %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+		success = false;
+	}
+	if (success)
+	{
+		success = SDL_RWwrite(file, &header, sizeof(header), 1) == 1;
+		for (size_t i = 0; i < sources.size() && success; ++i)
+		{
+			success = SDL_RWwrite(file, &sources[i].entry, sizeof(Entry), 1) == 1;
+		}
+		for (size_t i = 0; i < sources.size() && success; ++i)
+		{
+			success = sources[i].name.empty() || SDL_RWwrite(file, sources[i].name.data(), sources[i].name.size(), 1) == 1;
+		}
+		static const Uint8 padding[ALIGNMENT] = { 0 };
+		for (size_t i = 0; i < sources.size() && success; ++i)
+		{
+			size_t pad = (size_t)(sources[i].entry.offset - SDL_RWtell(file));
+			success = (pad == 0 || SDL_RWwrite(file, padding, pad, 1) == 1) &&
+				(sources[i].size == 0 || SDL_RWwrite(file, sources[i].data, sources[i].size, 1) == 1);
+		}
+		if (!success)
+		{
+			printf("Unable to write %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+		}
+		SDL_RWclose(file);
+	}
+
+	for (size_t i = 0; i < sources.size(); ++i)
+	{
+		SDL_free(sources[i].data);
+	}
+	return success;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#ifndef LASSETARCHIVE_H
+#define LASSETARCHIVE_H
+
+#include <string>
+#include <vector>
+#include "SDL.h"
+#include "LMappedFile.h"
+
+//Read only pack of many assets in one memory mapped file
+//Layout: header, entries sorted by path hash, path names, then the data of every entry aligned to ALIGNMENT
+class LAssetArchive
+{
+public:
+	//Entry data starts on a cache line
+	static const Uint32 ALIGNMENT = 64;
+
+	//Initializes variables
+	LAssetArchive();
+
+	//Unmaps the archive
+	~LAssetArchive();
+
+	//Maps the archive at path, false when it is missing or malformed
+	bool open(std::string path);
+	void close();
+	bool isOpen();
+
+	//Whether path, as passed to IMG_Load, is in the archive
+	bool contains(const std::string& path);
+
+	//Read only stream straight over the mapped entry, NULL when path is not archived
+	//Streams must be closed before the archive is
+	SDL_RWops* openEntry(const std::string& path);
+
+	//Archived entry when there is one, the loose file otherwise
+	SDL_RWops* openFile(const std::string& path);
+
+	//IMG_Load for archive paths, the file extension picks the format as it does for loose files
+	SDL_Surface* loadImage(const std::string& path);
+
+	//Image dimensions from the file header alone, for PNG, BMP, GIF and JPEG
+	//False for other formats and damaged headers, which then need a full decode
+	bool getImageSize(const std::string& path, int* w, int* h);
+
+	//Type hint for IMG_LoadTyped_RW, the extension IMG_Load would use
+	static const char* getImageType(const std::string& path);
+
+	//Writes files to an archive at path, entries are looked up by the names as given
+	static bool pack(std::string path, const std::vector<std::string>& files);
+
+	//Index key of a path, separators and a leading ./ do not matter
+	static std::string normalize(const std::string& path);
+	static Uint64 hashPath(const std::string& normalized);
+
+private:
+	struct Header
+	{
+		char magic[4];
+		Uint32 version;
+		Uint32 count;
+		Uint32 namesSize;
+	};
+
+	struct Entry
+	{
+		Uint64 hash;
+		Uint64 offset;
+		Uint64 size;
+		Uint32 nameOffset;
+		Uint32 nameLength;
+	};
+
+	//Binary search on the hash, then names break ties
+	const Entry* find(const std::string& path);
+
+	LMappedFile mFile;
+
+	//Views into the mapping
+	const Entry* mEntries;
+	const char* mNames;
+	Uint32 mCount;
+};
+
+extern LAssetArchive gAssetArchive;
+#endif
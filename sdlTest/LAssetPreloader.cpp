@@ -0,0 +1,170 @@
+#include"LAssetPreloader.h"
+#include"LTexture.h"
+#include"LStartupTrace.h"
+#include"LAssetArchive.h"
+
+#include <stdio.h>
+#include "SDL_image.h"
+
+LAssetPreloader gAssetPreloader;
+
+LAssetPreloader::LAssetPreloader()
+{
+	//Initialize
+	mStarted = false;
+	SDL_AtomicSet(&mRead.value, 0);
+}
+
+LAssetPreloader::~LAssetPreloader()
+{
+	//Deallocate
+	free();
+}
+
+void LAssetPreloader::addImage(std::string path)
+{
+	Asset asset;
+	asset.path = path;
+	asset.image = true;
+	SDL_AtomicSet(&asset.done.value, 0);
+	asset.data = NULL;
+	asset.size = 0;
+	mAssets.push_back(std::move(asset));
+}
+
+void LAssetPreloader::addFile(std::string path)
+{
+	addImage(path);
+	mAssets.back().image = false;
+}
+
+void LAssetPreloader::start()
+{
+	//The queue is fixed from here on, jobs point into it
+	mReader.clear();
+	mReaderAssets.clear();
+	for (size_t i = 0; i < mAssets.size(); ++i)
+	{
+		if (!gAssetArchive.contains(mAssets[i].path))
+		{
+			mReader.add(mAssets[i].path);
+			mReaderAssets.push_back((int)i);
+		}
+		else if (mAssets[i].image)
+		{
+			gJobSystem.run(decodeJob, &mAssets[i], &mAssets[i].done);
+		}
+	}
+
+	//Decodes are queued from the read as files land, so they are all counted by the time it finishes
+	gJobSystem.run(readJob, this, &mRead);
+	mStarted = true;
+}
+
+void LAssetPreloader::readJob(void* data)
+{
+	LAssetPreloader* preloader = (LAssetPreloader*)data;
+	preloader->mReader.readAll(onRead, preloader);
+}
+
+void LAssetPreloader::onRead(int index, void* data, size_t size, void* userdata)
+{
+	//Only this read touches the asset until it is handed to its decode
+	LAssetPreloader* preloader = (LAssetPreloader*)userdata;
+	Asset& asset = preloader->mAssets[preloader->mReaderAssets[index]];
+	asset.data = data;
+	asset.size = size;
+	if (asset.image && data != NULL)
+	{
+		gJobSystem.run(decodeJob, &asset, &asset.done);
+	}
+}
+
+void LAssetPreloader::decodeJob(void* data)
+{
+	//Only this job touches the asset until its counter drops
+	Asset& asset = *(Asset*)data;
+	if (asset.data != NULL)
+	{
+		asset.surface.reset(IMG_LoadTyped_RW(SDL_RWFromConstMem(asset.data, (int)asset.size), 1, LAssetArchive::getImageType(asset.path)));
+
+		//The encoded bytes are not needed after decode
+		SDL_free(asset.data);
+		asset.data = NULL;
+		asset.size = 0;
+	}
+	else
+	{
+		asset.surface.reset(gAssetArchive.loadImage(asset.path));
+	}
+	if (!asset.surface)
+	{
+		printf("Unable to preload image %s! SDL_image Error: %s\n", asset.path.c_str(), IMG_GetError());
+	}
+}
+
+int LAssetPreloader::wait(const std::string& path)
+{
+	int index = -1;
+	for (size_t i = 0; i < mAssets.size(); ++i)
+	{
+		if (mAssets[i].path == path)
+		{
+			index = (int)i;
+			break;
+		}
+	}
+	if (index < 0 || !mStarted)
+	{
+		return -1;
+	}
+
+	LSTARTUP_PHASE("wait for decode");
+	gJobSystem.wait(&mRead);
+	gJobSystem.wait(&mAssets[index].done);
+	return index;
+}
+
+bool LAssetPreloader::loadTexture(LTexture& texture, SDL_Renderer* ren, std::string path)
+{
+	int index = wait(path);
+	if (index < 0 || !mAssets[index].surface)
+	{
+		return texture.loadFromFile(ren, path);
+	}
+
+	LSTARTUP_PHASE(path.c_str());
+	bool success = texture.loadFromSurface(ren, mAssets[index].surface.get(), path);
+
+	//The decoded copy is not needed after upload
+	mAssets[index].surface.reset();
+	return success;
+}
+
+SDL_RWops* LAssetPreloader::openFile(std::string path)
+{
+	int index = wait(path);
+	if (index < 0 || mAssets[index].data == NULL)
+	{
+		return gAssetArchive.openFile(path);
+	}
+	return SDL_RWFromConstMem(mAssets[index].data, (int)mAssets[index].size);
+}
+
+void LAssetPreloader::free()
+{
+	if (mStarted)
+	{
+		gJobSystem.wait(&mRead);
+	}
+	for (size_t i = 0; i < mAssets.size(); ++i)
+	{
+		if (mStarted)
+		{
+			gJobSystem.wait(&mAssets[i].done);
+		}
+		SDL_free(mAssets[i].data);
+	}
+	mAssets.clear();
+	mStarted = false;
+}
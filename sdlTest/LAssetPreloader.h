@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef LASSETPRELOADER_H
+#define LASSETPRELOADER_H
+
+#include <iostream>
+#include <vector>
+#include "SDL.h"
+#include "LHandle.h"
+#include "LJobSystem.h"
+#include "LBatchReader.h"
+
+class LTexture;
+
+//Reads and decodes startup assets on the job system while the main thread creates the window and renderer
+//Loose files are read as one batch, images are decoded from memory as their read lands; uploads stay on the main thread
+class LAssetPreloader
+{
+public:
+	//Initializes variables
+	LAssetPreloader();
+
+	//Waits for the jobs and frees anything not taken
+	~LAssetPreloader();
+
+	//Queues files before start(), images are decoded, the rest kept as bytes
+	void addImage(std::string path);
+	void addFile(std::string path);
+
+	//Starts the batch read, call IMG_Init first
+	void start();
+
+	//Loads the texture from its preloaded image, waiting for the decode if needed
+	//Falls back to LTexture::loadFromFile for paths that were not queued
+	bool loadTexture(LTexture& texture, SDL_Renderer* ren, std::string path);
+
+	//Opens a preloaded file from memory, or from disk if it was not queued
+	//The memory stays valid until free()
+	SDL_RWops* openFile(std::string path);
+
+	//Waits for the jobs and frees every result
+	void free();
+
+private:
+	struct Asset
+	{
+		std::string path;
+		bool image;
+		LJobCounter done;
+		LSurfaceHandle surface;
+		void* data;
+		size_t size;
+	};
+
+	//Files in the archive skip the read and decode straight from the mapping
+	static void readJob(void* data);
+	static void onRead(int index, void* data, size_t size, void* userdata);
+	static void decodeJob(void* data);
+
+	//Index of path in the queue, -1 if missing; waits for it to finish
+	int wait(const std::string& path);
+
+	std::vector<Asset> mAssets;
+	bool mStarted;
+
+	//Loose files, and the asset each one belongs to
+	LBatchReader mReader;
+	std::vector<int> mReaderAssets;
+	LJobCounter mRead;
+};
+
+extern LAssetPreloader gAssetPreloader;
+#endif
@@ -0,0 +1,430 @@
+#include"LAssetWatcher.h"
+#include"LTexture.h"
+#include"LAssetArchive.h"
+#include"LMemoryTracker.h"
+#include"LProfiler.h"
+#include"LUploadScheduler.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include "SDL_image.h"
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+
+LAssetWatcher gAssetWatcher;
+
+LAssetWatcher::LAssetWatcher()
+{
+	//Initialize
+	mReloads = 0;
+	mLock = SDL_CreateMutex();
+	mReadyLock = SDL_CreateMutex();
+	SDL_AtomicSet(&mDecoding.value, 0);
+	mThread = NULL;
+	SDL_AtomicSet(&mQuit, 0);
+	mInotify = -1;
+}
+
+LAssetWatcher::~LAssetWatcher()
+{
+	//Deallocate
+	stop();
+	SDL_DestroyMutex(mReadyLock);
+	SDL_DestroyMutex(mLock);
+}
+
+bool LAssetWatcher::start()
+{
+	if (mThread != NULL)
+	{
+		return true;
+	}
+
+#if defined(__linux__)
+	mInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (mInotify < 0)
+	{
+		printf("Unable to start inotify, polling for asset changes instead\n");
+	}
+#endif
+	SDL_LockMutex(mLock);
+	mDirectories.clear();
+	mDirectoryWatches.clear();
+	for (size_t i = 0; i < mPaths.size(); ++i)
+	{
+		mStamps[i] = getStamp(mPaths[i]);
+		watchDirectory(mPaths[i]);
+	}
+	SDL_UnlockMutex(mLock);
+
+	SDL_AtomicSet(&mQuit, 0);
+	mThread = SDL_CreateThread(watchThread, "AssetWatcher", this);
+	if (mThread == NULL)
+	{
+		printf("Unable to create asset watcher thread! SDL Error: %s\n", SDL_GetError());
+		stop();
+		return false;
+	}
+	return true;
+}
+
+void LAssetWatcher::stop()
+{
+	if (mThread != NULL)
+	{
+		SDL_AtomicSet(&mQuit, 1);
+		SDL_WaitThread(mThread, NULL);
+		mThread = NULL;
+	}
+#if defined(__linux__)
+	if (mInotify >= 0)
+	{
+		close(mInotify);
+		mInotify = -1;
+	}
+#endif
+	mChanges.clear();
+
+	//Decodes already queued still land in mReady
+	gJobSystem.wait(&mDecoding);
+	SDL_LockMutex(mReadyLock);
+	for (size_t i = 0; i < mReady.size(); ++i)
+	{
+		SDL_FreeSurface(mReady[i]->surface);
+		delete mReady[i];
+	}
+	mReady.clear();
+	SDL_UnlockMutex(mReadyLock);
+}
+
+bool LAssetWatcher::isRunning()
+{
+	return mThread != NULL;
+}
+
+void LAssetWatcher::watch(LTexture* texture, const std::string& path)
+{
+	std::string normalized = LAssetArchive::normalize(path);
+	Watched watched = { texture, normalized };
+	mTextures.push_back(watched);
+
+	SDL_LockMutex(mLock);
+	if (std::find(mPaths.begin(), mPaths.end(), normalized) == mPaths.end())
+	{
+		mPaths.push_back(normalized);
+		mStamps.push_back(getStamp(normalized));
+		if (mThread != NULL)
+		{
+			watchDirectory(normalized);
+		}
+	}
+	SDL_UnlockMutex(mLock);
+}
+
+void LAssetWatcher::forget(LTexture* texture)
+{
+	//Paths stay watched, a later load of the same file reuses them
+	for (size_t i = 0; i < mTextures.size();)
+	{
+		if (mTextures[i].texture == texture)
+		{
+			mTextures[i] = mTextures.back();
+			mTextures.pop_back();
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+void LAssetWatcher::moved(LTexture* from, LTexture* to)
+{
+	for (size_t i = 0; i < mTextures.size(); ++i)
+	{
+		if (mTextures[i].texture == from)
+		{
+			mTextures[i].texture = to;
+		}
+	}
+}
+
+void LAssetWatcher::update(SDL_Renderer* ren)
+{
+	//Never wait on the watcher, whatever is locked now is picked up next frame
+	std::vector<Reload*> ready;
+	if (SDL_TryLockMutex(mReadyLock) != 0)
+	{
+		return;
+	}
+	ready.swap(mReady);
+	SDL_UnlockMutex(mReadyLock);
+	if (ready.empty())
+	{
+		return;
+	}
+
+	LPROFILE_ZONE("LAssetWatcher::update");
+	for (size_t i = 0; i < ready.size(); ++i)
+	{
+		Reload* reload = ready[i];
+
+		//A newer decode of the same file makes this one redundant
+		bool superseded = false;
+		for (size_t j = i + 1; j < ready.size() && !superseded; ++j)
+		{
+			superseded = ready[j]->path == reload->path;
+		}
+		if (!superseded)
+		{
+			for (size_t t = 0; t < mTextures.size(); ++t)
+			{
+				if (mTextures[t].path != reload->path)
+				{
+					continue;
+				}
+				if (gUploadScheduler.isEnabled())
+				{
+					//The scheduler takes its own copy, one per texture
+					SDL_Surface* copy = SDL_ConvertSurface(reload->surface, reload->surface->format, 0);
+					if (copy != NULL)
+					{
+						gUploadScheduler.upload(mTextures[t].texture, copy, reload->path, mTextures[t].texture->getPriority(), true);
+					}
+				}
+				else
+				{
+					mTextures[t].texture->reloadFromSurface(ren, reload->surface, reload->path);
+				}
+			}
+			printf("Reloaded %s\n", reload->path.c_str());
+			++mReloads;
+		}
+		SDL_FreeSurface(reload->surface);
+		delete reload;
+	}
+}
+
+bool LAssetWatcher::hasReloads()
+{
+	if (SDL_TryLockMutex(mReadyLock) != 0)
+	{
+		return false;
+	}
+	bool ready = !mReady.empty();
+	SDL_UnlockMutex(mReadyLock);
+	return ready;
+}
+
+Uint32 LAssetWatcher::getReloadCount()
+{
+	return mReloads;
+}
+
+bool LAssetWatcher::isWatched(const std::string& path)
+{
+	SDL_LockMutex(mLock);
+	bool watched = std::find(mPaths.begin(), mPaths.end(), path) != mPaths.end();
+	SDL_UnlockMutex(mLock);
+	return watched;
+}
+
+void LAssetWatcher::watchDirectory(const std::string& path)
+{
+	size_t slash = path.find_last_of('/');
+	std::string directory = slash != std::string::npos ? path.substr(0, slash) : ".";
+	if (std::find(mDirectories.begin(), mDirectories.end(), directory) != mDirectories.end())
+	{
+		return;
+	}
+
+	//Editors often save by renaming a temporary file over the original, hence MOVED_TO
+	int watch = -1;
+#if defined(__linux__)
+	if (mInotify >= 0)
+	{
+		watch = inotify_add_watch(mInotify, directory.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (watch < 0)
+		{
+			printf("Unable to watch %s for changes\n", directory.c_str());
+		}
+	}
+#endif
+	mDirectories.push_back(directory);
+	mDirectoryWatches.push_back(watch);
+}
+
+LAssetWatcher::FileStamp LAssetWatcher::getStamp(const std::string& path)
+{
+	FileStamp stamp = { -1, -1 };
+#if defined(_WIN32)
+	struct _stat64 info;
+	if (_stat64(path.c_str(), &info) == 0)
+#else
+	struct stat info;
+	if (stat(path.c_str(), &info) == 0)
+#endif
+	{
+		stamp.time = (Sint64)info.st_mtime;
+		stamp.size = (Sint64)info.st_size;
+	}
+	return stamp;
+}
+
+void LAssetWatcher::changed(const std::string& path, Uint32 now)
+{
+	if (!isWatched(path))
+	{
+		return;
+	}
+
+	//A burst of writes keeps pushing the same change back
+	for (size_t i = 0; i < mChanges.size(); ++i)
+	{
+		if (mChanges[i].path == path)
+		{
+			mChanges[i].lastEvent = now;
+			return;
+		}
+	}
+	Change change = { path, now };
+	mChanges.push_back(change);
+}
+
+void LAssetWatcher::flushChanges(Uint32 now)
+{
+	for (size_t i = 0; i < mChanges.size();)
+	{
+		if (SDL_TICKS_PASSED(now, mChanges[i].lastEvent + QUIET_MS))
+		{
+			Reload* reload = new Reload;
+			reload->watcher = this;
+			reload->path = mChanges[i].path;
+			reload->surface = NULL;
+			gJobSystem.run(decodeJob, reload, &mDecoding);
+
+			mChanges[i] = mChanges.back();
+			mChanges.pop_back();
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+void LAssetWatcher::decodeJob(void* data)
+{
+	//Straight from disk, an archive holds the old copy
+	Reload* reload = (Reload*)data;
+	reload->surface = IMG_Load(reload->path.c_str());
+	if (reload->surface == NULL)
+	{
+		//Half written files fail here, the write that finishes them queues another decode
+		printf("Unable to reload %s! SDL_image Error: %s\n", reload->path.c_str(), IMG_GetError());
+		delete reload;
+		return;
+	}
+
+	LAssetWatcher* watcher = reload->watcher;
+	SDL_LockMutex(watcher->mReadyLock);
+	watcher->mReady.push_back(reload);
+	SDL_UnlockMutex(watcher->mReadyLock);
+}
+
+void LAssetWatcher::waitInotify()
+{
+#if defined(__linux__)
+	//Short waits while changes settle, longer ones otherwise, both short enough for stop()
+	pollfd descriptor = { mInotify, POLLIN, 0 };
+	if (poll(&descriptor, 1, mChanges.empty() ? 100 : 20) <= 0)
+	{
+		return;
+	}
+
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	for (;;)
+	{
+		ssize_t length = read(mInotify, buffer, sizeof(buffer));
+		if (length <= 0)
+		{
+			break;
+		}
+		Uint32 now = SDL_GetTicks();
+		for (char* p = buffer; p < buffer + length;)
+		{
+			const inotify_event* event = (const inotify_event*)p;
+			p += sizeof(inotify_event) + event->len;
+			if (event->len == 0)
+			{
+				continue;
+			}
+
+			std::string directory;
+			SDL_LockMutex(mLock);
+			for (size_t i = 0; i < mDirectoryWatches.size(); ++i)
+			{
+				if (mDirectoryWatches[i] == event->wd)
+				{
+					directory = mDirectories[i];
+					break;
+				}
+			}
+			SDL_UnlockMutex(mLock);
+			if (!directory.empty())
+			{
+				changed(directory == "." ? std::string(event->name) : directory + "/" + event->name, now);
+			}
+		}
+	}
+#endif
+}
+
+void LAssetWatcher::pollStamps()
+{
+	//Short sleeps while changes settle, so writes still landing keep pushing them back
+	SDL_Delay(mChanges.empty() ? POLL_MS : 20);
+
+	//Stat every watched file, comparing against the last look
+	Uint32 now = SDL_GetTicks();
+	std::vector<std::string> paths;
+	SDL_LockMutex(mLock);
+	for (size_t i = 0; i < mPaths.size(); ++i)
+	{
+		FileStamp stamp = getStamp(mPaths[i]);
+		if (stamp.time != mStamps[i].time || stamp.size != mStamps[i].size)
+		{
+			mStamps[i] = stamp;
+			paths.push_back(mPaths[i]);
+		}
+	}
+	SDL_UnlockMutex(mLock);
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		changed(paths[i], now);
+	}
+}
+
+int SDLCALL LAssetWatcher::watchThread(void* data)
+{
+	LAssetWatcher* watcher = (LAssetWatcher*)data;
+	while (SDL_AtomicGet(&watcher->mQuit) == 0)
+	{
+		if (watcher->mInotify >= 0)
+		{
+			watcher->waitInotify();
+		}
+		else
+		{
+			watcher->pollStamps();
+		}
+		watcher->flushChanges(SDL_GetTicks());
+	}
+	return 0;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#ifndef LASSETWATCHER_H
+#define LASSETWATCHER_H
+
+#include <string>
+#include <vector>
+#include "SDL.h"
+#include "LJobSystem.h"
+
+class LTexture;
+
+//Reloads textures whose image files change on disk while the app runs
+//A watcher thread waits on inotify, or polls modification times elsewhere, and waits for writes to settle
+//Changed files are decoded on the job system, update() swaps the pixels in on the main thread
+class LAssetWatcher
+{
+public:
+	//Writes closer together than this are one change
+	static const Uint32 QUIET_MS = 150;
+
+	//Modification time polling interval without inotify
+	static const Uint32 POLL_MS = 250;
+
+	//Initializes variables
+	LAssetWatcher();
+
+	//Stops the thread and frees pending reloads
+	~LAssetWatcher();
+
+	//Starts watching every registered path
+	bool start();
+	void stop();
+	bool isRunning();
+
+	//Registers texture as loaded from path, LTexture does this on load
+	void watch(LTexture* texture, const std::string& path);
+
+	//Unregisters a freed texture
+	void forget(LTexture* texture);
+
+	//Points the registration of a moved texture at its new home
+	void moved(LTexture* from, LTexture* to);
+
+	//Uploads finished reloads into their textures, never waits for the watcher or decodes
+	void update(SDL_Renderer* ren);
+
+	//Whether update() has decoded reloads to apply, false while the watcher holds them
+	bool hasReloads();
+
+	//Reloads applied so far
+	Uint32 getReloadCount();
+
+private:
+	struct Watched
+	{
+		LTexture* texture;
+		std::string path;
+	};
+
+	//A path waiting for its writes to settle
+	struct Change
+	{
+		std::string path;
+		Uint32 lastEvent;
+	};
+
+	//Modification time and size, either changing counts as a write
+	struct FileStamp
+	{
+		Sint64 time;
+		Sint64 size;
+	};
+
+	struct Reload
+	{
+		LAssetWatcher* watcher;
+		std::string path;
+		SDL_Surface* surface;
+	};
+
+	static int SDLCALL watchThread(void* data);
+	static void decodeJob(void* data);
+
+	//Watcher thread side: notes a write, and queues decodes once a path went quiet
+	void changed(const std::string& path, Uint32 now);
+	void flushChanges(Uint32 now);
+
+	//Watched paths, shared with the watcher thread
+	bool isWatched(const std::string& path);
+
+	//Watcher thread: gathers writes since the last call, waiting a little when there are none
+	void waitInotify();
+	void pollStamps();
+	static FileStamp getStamp(const std::string& path);
+
+	//Adds an inotify watch for the directory of path if it has none yet, call with mLock held
+	void watchDirectory(const std::string& path);
+
+	//Main thread only
+	std::vector<Watched> mTextures;
+	Uint32 mReloads;
+
+	//Guards mPaths, mStamps, mDirectories and mDirectoryWatches
+	SDL_mutex* mLock;
+	std::vector<std::string> mPaths;
+	std::vector<FileStamp> mStamps;
+	std::vector<std::string> mDirectories;
+	std::vector<int> mDirectoryWatches;
+
+	//Watcher thread only
+	std::vector<Change> mChanges;
+
+	//Decoded images waiting for update()
+	SDL_mutex* mReadyLock;
+	std::vector<Reload*> mReady;
+	LJobCounter mDecoding;
+
+	SDL_Thread* mThread;
+	SDL_atomic_t mQuit;
+	int mInotify;
+};
+
+extern LAssetWatcher gAssetWatcher;
+#endif
@@ -0,0 +1,352 @@
+#include"LBatchReader.h"
+#include"LJobSystem.h"
+#include"LProfiler.h"
+
+#include <stdio.h>
+
+//io_uring needs Linux 5.1 headers; the syscalls are made directly so no liburing is needed
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define LBATCHREADER_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+#endif
+
+LBatchReader::LBatchReader()
+{
+	//Initialize
+	mIoUring = true;
+	mUsedIoUring = false;
+}
+
+int LBatchReader::add(std::string path)
+{
+	mPaths.push_back(path);
+	return (int)mPaths.size() - 1;
+}
+
+void LBatchReader::clear()
+{
+	mPaths.clear();
+}
+
+int LBatchReader::getCount()
+{
+	return (int)mPaths.size();
+}
+
+const std::string& LBatchReader::getPath(int index)
+{
+	return mPaths[index];
+}
+
+void LBatchReader::setIoUring(bool enabled)
+{
+	mIoUring = enabled;
+}
+
+bool LBatchReader::usedIoUring()
+{
+	return mUsedIoUring;
+}
+
+void LBatchReader::readAll(ReadFunc func, void* userdata)
+{
+	LPROFILE_ZONE("LBatchReader::readAll");
+
+	mUsedIoUring = mIoUring && readIoUring(func, userdata);
+	if (!mUsedIoUring)
+	{
+		readJobs(func, userdata);
+	}
+}
+
+void LBatchReader::readJobs(ReadFunc func, void* userdata)
+{
+	//One blocking read per job, as many at once as there are threads
+	std::vector<ReadJob> jobs(mPaths.size());
+	LJobCounter counter;
+	SDL_AtomicSet(&counter.value, 0);
+	for (size_t i = 0; i < mPaths.size(); ++i)
+	{
+		jobs[i].reader = this;
+		jobs[i].index = (int)i;
+		jobs[i].func = func;
+		jobs[i].userdata = userdata;
+		gJobSystem.run(readJob, &jobs[i], &counter);
+	}
+	gJobSystem.wait(&counter);
+}
+
+void LBatchReader::readJob(void* data)
+{
+	ReadJob& job = *(ReadJob*)data;
+	const std::string& path = job.reader->mPaths[job.index];
+	size_t size = 0;
+	void* contents = SDL_LoadFile(path.c_str(), &size);
+	if (contents == NULL)
+	{
+		printf("Unable to read %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+	}
+	job.func(job.index, contents, size, job.userdata);
+}
+
+#if defined(LBATCHREADER_IO_URING)
+namespace
+{
+	//Submission and completion rings shared with the kernel
+	struct Ring
+	{
+		int fd;
+		void* sqMap;
+		size_t sqMapSize;
+		void* cqMap;
+		size_t cqMapSize;
+		io_uring_sqe* sqes;
+		size_t sqesSize;
+		unsigned* sqHead;
+		unsigned* sqTail;
+		unsigned* sqMask;
+		unsigned* sqArray;
+		unsigned* cqHead;
+		unsigned* cqTail;
+		unsigned* cqMask;
+		io_uring_cqe* cqes;
+		unsigned pending;
+	};
+
+	//A file being read, the iovec must live until its read completes
+	struct RingFile
+	{
+		//-1 once closed and handed on
+		int fd;
+		Uint8* data;
+		size_t size;
+		size_t done;
+		iovec iov;
+	};
+
+	bool setupRing(Ring& ring, unsigned entries)
+	{
+		SDL_zero(ring);
+		io_uring_params params;
+		SDL_zero(params);
+		ring.fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+		if (ring.fd < 0)
+		{
+			//Old kernels and sandboxes without io_uring land here
+			return false;
+		}
+
+		ring.sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		ring.cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (singleMap)
+		{
+			ring.sqMapSize = SDL_max(ring.sqMapSize, ring.cqMapSize);
+			ring.cqMapSize = ring.sqMapSize;
+		}
+		ring.sqMap = mmap(NULL, ring.sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+		ring.cqMap = singleMap ? ring.sqMap :
+			mmap(NULL, ring.cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+		ring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		ring.sqes = (io_uring_sqe*)mmap(NULL, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+		if (ring.sqMap == MAP_FAILED || ring.cqMap == MAP_FAILED || ring.sqes == MAP_FAILED)
+		{
+			printf("Unable to map io_uring: %s\n", strerror(errno));
+			if (ring.sqMap != MAP_FAILED) munmap(ring.sqMap, ring.sqMapSize);
+			if (!singleMap && ring.cqMap != MAP_FAILED) munmap(ring.cqMap, ring.cqMapSize);
+			if (ring.sqes != MAP_FAILED) munmap(ring.sqes, ring.sqesSize);
+			close(ring.fd);
+			return false;
+		}
+
+		Uint8* sq = (Uint8*)ring.sqMap;
+		ring.sqHead = (unsigned*)(sq + params.sq_off.head);
+		ring.sqTail = (unsigned*)(sq + params.sq_off.tail);
+		ring.sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+		ring.sqArray = (unsigned*)(sq + params.sq_off.array);
+		Uint8* cq = (Uint8*)ring.cqMap;
+		ring.cqHead = (unsigned*)(cq + params.cq_off.head);
+		ring.cqTail = (unsigned*)(cq + params.cq_off.tail);
+		ring.cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+		ring.cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+		return true;
+	}
+
+	void destroyRing(Ring& ring)
+	{
+		munmap(ring.sqes, ring.sqesSize);
+		if (ring.cqMap != ring.sqMap)
+		{
+			munmap(ring.cqMap, ring.cqMapSize);
+		}
+		munmap(ring.sqMap, ring.sqMapSize);
+		close(ring.fd);
+	}
+
+	//Queues a read of the rest of file, made visible to the kernel by the next enter
+	void queueRead(Ring& ring, RingFile& file, int index)
+	{
+		unsigned tail = *ring.sqTail;
+		unsigned slot = tail & *ring.sqMask;
+		io_uring_sqe& sqe = ring.sqes[slot];
+		SDL_zero(sqe);
+		file.iov.iov_base = file.data + file.done;
+		file.iov.iov_len = file.size - file.done;
+		sqe.opcode = IORING_OP_READV;
+		sqe.fd = file.fd;
+		sqe.off = file.done;
+		sqe.addr = (Uint64)(uintptr_t)&file.iov;
+		sqe.len = 1;
+		sqe.user_data = (Uint64)index;
+		ring.sqArray[slot] = slot;
+		__atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+		++ring.pending;
+	}
+
+	//Submits queued reads and waits for at least one completion when waitFor is set
+	bool enterRing(Ring& ring, bool waitFor)
+	{
+		for (;;)
+		{
+			int submitted = (int)syscall(__NR_io_uring_enter, ring.fd, ring.pending, waitFor ? 1 : 0,
+				waitFor ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+			if (submitted >= 0)
+			{
+				ring.pending -= (unsigned)submitted;
+				return true;
+			}
+			if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+			{
+				printf("io_uring_enter failed: %s\n", strerror(errno));
+				return false;
+			}
+		}
+	}
+}
+
+bool LBatchReader::readIoUring(ReadFunc func, void* userdata)
+{
+	Ring ring;
+	if (!setupRing(ring, QUEUE_DEPTH))
+	{
+		return false;
+	}
+
+	//Files are opened as slots free up so at most QUEUE_DEPTH descriptors are open
+	std::vector<RingFile> files(mPaths.size());
+	size_t next = 0;
+	unsigned inFlight = 0;
+	bool failed = false;
+	while ((next < files.size() || inFlight > 0) && !failed)
+	{
+		while (next < files.size() && inFlight < QUEUE_DEPTH)
+		{
+			int index = (int)next++;
+			RingFile& file = files[index];
+			file.fd = open(mPaths[index].c_str(), O_RDONLY | O_CLOEXEC);
+			struct stat info;
+			if (file.fd < 0 || fstat(file.fd, &info) != 0)
+			{
+				printf("Unable to read %s: %s\n", mPaths[index].c_str(), strerror(errno));
+				if (file.fd >= 0)
+				{
+					close(file.fd);
+				}
+				file.fd = -1;
+				func(index, NULL, 0, userdata);
+				continue;
+			}
+			file.size = (size_t)info.st_size;
+			file.done = 0;
+			file.data = (Uint8*)SDL_malloc(file.size > 0 ? file.size : 1);
+			if (file.size == 0)
+			{
+				close(file.fd);
+				file.fd = -1;
+				func(index, file.data, 0, userdata);
+				continue;
+			}
+			queueRead(ring, file, index);
+			++inFlight;
+		}
+
+		if (!enterRing(ring, inFlight > 0))
+		{
+			failed = true;
+			break;
+		}
+
+		//Hand every finished file on; short reads go back on the ring for the rest
+		unsigned head = *ring.cqHead;
+		unsigned tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+		for (; head != tail; ++head)
+		{
+			const io_uring_cqe& cqe = ring.cqes[head & *ring.cqMask];
+			int index = (int)cqe.user_data;
+			RingFile& file = files[index];
+			if (cqe.res > 0)
+			{
+				file.done += (size_t)cqe.res;
+				if (file.done < file.size)
+				{
+					queueRead(ring, file, index);
+					continue;
+				}
+			}
+			close(file.fd);
+			file.fd = -1;
+			--inFlight;
+			if (cqe.res < 0)
+			{
+				printf("Unable to read %s: %s\n", mPaths[index].c_str(), strerror(-cqe.res));
+				SDL_free(file.data);
+				func(index, NULL, 0, userdata);
+			}
+			else
+			{
+				//A file that shrank since fstat delivers what was there
+				func(index, file.data, file.done, userdata);
+			}
+		}
+		__atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+	}
+
+	destroyRing(ring);
+
+	//A broken ring still owes every caller its file
+	//Buffers of reads left in flight are dropped without freeing, the kernel may still write them
+	if (failed)
+	{
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			//Files already closed were handed on, short reads included
+			bool started = i < next && files[i].fd >= 0;
+			if (started)
+			{
+				close(files[i].fd);
+			}
+			if (started || i >= next)
+			{
+				ReadJob job = { this, (int)i, func, userdata };
+				readJob(&job);
+			}
+		}
+	}
+	return true;
+}
+#else
+bool LBatchReader::readIoUring(ReadFunc func, void* userdata)
+{
+	return false;
+}
+#endif
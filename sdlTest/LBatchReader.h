@@ -0,0 +1,59 @@
+#pragma once
+
+#ifndef LBATCHREADER_H
+#define LBATCHREADER_H
+
+#include <string>
+#include <vector>
+#include "SDL.h"
+
+//Reads a whole batch of loose files into memory at once
+//On Linux every read goes through one io_uring, elsewhere or when that fails each file is a job on gJobSystem
+class LBatchReader
+{
+public:
+	//Reads kept in flight on the ring
+	static const unsigned QUEUE_DEPTH = 64;
+
+	//Called once per file as its read completes, possibly from several threads at once
+	//data is NULL when the file could not be read, otherwise the callee owns it and frees it with SDL_free
+	typedef void (*ReadFunc)(int index, void* data, size_t size, void* userdata);
+
+	//Initializes variables
+	LBatchReader();
+
+	//Queues a file, returns its index for ReadFunc
+	int add(std::string path);
+	void clear();
+
+	int getCount();
+	const std::string& getPath(int index);
+
+	//Reads every queued file and returns once func ran for each of them
+	void readAll(ReadFunc func, void* userdata);
+
+	//io_uring is used when built in and allowed; false forces the job system
+	void setIoUring(bool enabled);
+
+	//Whether the last readAll() went through io_uring
+	bool usedIoUring();
+
+private:
+	struct ReadJob
+	{
+		LBatchReader* reader;
+		int index;
+		ReadFunc func;
+		void* userdata;
+	};
+
+	//False when the ring could not be set up, before any file was delivered
+	bool readIoUring(ReadFunc func, void* userdata);
+	void readJobs(ReadFunc func, void* userdata);
+	static void readJob(void* data);
+
+	std::vector<std::string> mPaths;
+	bool mIoUring;
+	bool mUsedIoUring;
+};
+#endif
@@ -0,0 +1,199 @@
+#include"LBitmap.h"
+#include"LMemoryTracker.h"
+
+#include <stdio.h>
+
+//Built with -mssse3 or /arch:AVX and up, otherwise rows convert a pixel at a time
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define BITMAP_SSSE3 1
+#endif
+
+//Header fields, offsets from the start of the file
+static const size_t BMP_PIXEL_OFFSET = 10;
+static const size_t BMP_INFO_SIZE = 14;
+static const size_t BMP_WIDTH = 18;
+static const size_t BMP_HEIGHT = 22;
+static const size_t BMP_BITS = 28;
+static const size_t BMP_COMPRESSION = 30;
+static const size_t BMP_MASKS = 54;
+static const Uint32 BI_RGB = 0;
+static const Uint32 BI_BITFIELDS = 3;
+
+static Uint32 readLE32(const Uint8* data)
+{
+	Uint32 value;
+	SDL_memcpy(&value, data, sizeof(value));
+	return SDL_SwapLE32(value);
+}
+
+//One BGR row into ARGB8888 with opaque alpha
+static void convertRow(const Uint8* src, Uint32* dst, int w)
+{
+	int x = 0;
+
+	//Four pixels from one 16 byte load, 12 bytes spread to 16 with a zero in each alpha byte
+	//The load reads 4 bytes past the pixels, so it stops while the row still has them
+#if defined(BITMAP_SSSE3)
+	__m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	__m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	for (; x + 6 <= w; x += 4)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(src + x * 3));
+		_mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(_mm_shuffle_epi8(v, spread), alpha));
+	}
+#endif
+
+	//Every pixel is read as four bytes, so the last one is done separately to stay inside the row
+	for (; x + 1 < w; ++x)
+	{
+		dst[x] = (readLE32(src + x * 3) & 0x00FFFFFF) | 0xFF000000;
+	}
+	for (; x < w; ++x)
+	{
+		const Uint8* p = src + x * 3;
+		dst[x] = 0xFF000000 | ((Uint32)p[2] << 16) | ((Uint32)p[1] << 8) | p[0];
+	}
+}
+
+LBitmap::LBitmap()
+{
+	//Initialize
+	mSurface = NULL;
+	mMapped = false;
+}
+
+LBitmap::~LBitmap()
+{
+	//Deallocate
+	free();
+}
+
+bool LBitmap::loadFromFile(std::string path)
+{
+	//Get rid of preexisting surface
+	free();
+
+	//Copy on write, so anything SDL writes into the surface stays out of the file
+	if (mFile.open(path, true))
+	{
+		mSurface = createSurface(mFile.getData(), mFile.getSize());
+	}
+	if (!mMapped)
+	{
+		mFile.close();
+	}
+
+	//Formats the fast paths do not handle
+	if (mSurface == NULL)
+	{
+		mSurface = SDL_LoadBMP(path.c_str());
+		if (mSurface == NULL)
+		{
+			printf("Unable to load bitmap %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+			return false;
+		}
+	}
+	return true;
+}
+
+SDL_Surface* LBitmap::createSurface(Uint8* data, size_t size)
+{
+	if (size < BMP_MASKS || data[0] != 'B' || data[1] != 'M')
+	{
+		return NULL;
+	}
+	Uint32 pixelOffset = readLE32(data + BMP_PIXEL_OFFSET);
+	Uint32 infoSize = readLE32(data + BMP_INFO_SIZE);
+	int w = (int)readLE32(data + BMP_WIDTH);
+	int height = (int)readLE32(data + BMP_HEIGHT);
+	int bits = data[BMP_BITS] | (data[BMP_BITS + 1] << 8);
+	Uint32 compression = readLE32(data + BMP_COMPRESSION);
+	if (infoSize < 40 || w <= 0 || height == 0 || height == SDL_MIN_SINT32)
+	{
+		return NULL;
+	}
+
+	Uint32 format = SDL_PIXELFORMAT_UNKNOWN;
+	if (bits == 24 && compression == BI_RGB)
+	{
+		format = SDL_PIXELFORMAT_BGR24;
+	}
+	else if (bits == 32 && compression == BI_RGB)
+	{
+		format = SDL_PIXELFORMAT_RGB888;
+	}
+	else if (bits == 32 && compression == BI_BITFIELDS && size >= BMP_MASKS + 16)
+	{
+		//Alpha mask only exists in version 4 and later headers
+		Uint32 alphaMask = infoSize >= 56 ? readLE32(data + BMP_MASKS + 12) : 0;
+		format = SDL_MasksToPixelFormatEnum(32, readLE32(data + BMP_MASKS), readLE32(data + BMP_MASKS + 4),
+			readLE32(data + BMP_MASKS + 8), alphaMask);
+	}
+	if (format == SDL_PIXELFORMAT_UNKNOWN)
+	{
+		return NULL;
+	}
+
+	//Rows are padded to four bytes
+	int h = height < 0 ? -height : height;
+	Uint64 rowBytes = (((Uint64)w * bits + 31) / 32) * 4;
+	if (rowBytes > SDL_MAX_SINT32 || (Uint64)pixelOffset + rowBytes * h > size)
+	{
+		return NULL;
+	}
+	int pitch = (int)rowBytes;
+	Uint8* pixels = data + pixelOffset;
+
+	//Top-down rows are already in surface order
+	if (height < 0)
+	{
+		SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(pixels, w, h, bits, pitch, format);
+		mMapped = surface != NULL;
+		return surface;
+	}
+
+	//Bottom-up rows are flipped, and 24 bit ones widened, straight out of the mapping
+	Uint32 dstFormat = bits == 24 ? (Uint32)SDL_PIXELFORMAT_ARGB8888 : format;
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, dstFormat);
+	if (surface == NULL)
+	{
+		return NULL;
+	}
+	for (int y = 0; y < h; ++y)
+	{
+		const Uint8* src = pixels + (size_t)(h - 1 - y) * pitch;
+		Uint32* dst = (Uint32*)((Uint8*)surface->pixels + (size_t)y * surface->pitch);
+		if (bits == 24)
+		{
+			convertRow(src, dst, w);
+		}
+		else
+		{
+			SDL_memcpy(dst, src, (size_t)w * 4);
+		}
+	}
+	return surface;
+}
+
+void LBitmap::free()
+{
+	//The surface goes before the pixels it may point at
+	if (mSurface != NULL)
+	{
+		freeTrackedSurface(mSurface);
+		mSurface = NULL;
+	}
+	mFile.close();
+	mMapped = false;
+}
+
+SDL_Surface* LBitmap::getSurface()
+{
+	return mSurface;
+}
+
+bool LBitmap::isMapped()
+{
+	return mMapped;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#ifndef LBITMAP_H
+#define LBITMAP_H
+
+#include <string>
+#include "SDL.h"
+#include "LMappedFile.h"
+
+//Uncompressed BMP without SDL_LoadBMP's copy
+//Top-down 24 and 32 bit files are mapped and the surface points straight at the file's pixels
+//Bottom-up files are flipped in one pass, 24 bit ones converted to ARGB8888 on the way
+//Anything else, such as palettes or RLE, goes through SDL_LoadBMP
+class LBitmap
+{
+public:
+	//Initializes variables
+	LBitmap();
+
+	//Deallocates the surface and the mapping
+	~LBitmap();
+
+	//Bitmaps own their surface and cannot be copied
+	LBitmap(const LBitmap&) = delete;
+	LBitmap& operator=(const LBitmap&) = delete;
+
+	//Loads the BMP at path
+	bool loadFromFile(std::string path);
+
+	//Deallocates the surface and the mapping
+	void free();
+
+	//Valid until free(), writes to a mapped surface stay in memory
+	SDL_Surface* getSurface();
+
+	//Whether the surface pixels live in the mapped file
+	bool isMapped();
+
+private:
+	//Surface over or flipped from the pixels inside data, NULL if the format is not handled
+	SDL_Surface* createSurface(Uint8* data, size_t size);
+
+	SDL_Surface* mSurface;
+	LMappedFile mFile;
+	bool mMapped;
+};
+#endif
@@ -0,0 +1,172 @@
+#include"LCommandList.h"
+#include"LRenderStats.h"
+#include"LJobSystem.h"
+
+LCommandList::LCommandList()
+{
+}
+
+void LCommandList::reserve(size_t commands)
+{
+	mCommands.reserve(commands);
+}
+
+void LCommandList::clear()
+{
+	mCommands.clear();
+}
+
+LRenderCommand& LCommandList::push(Uint8 type)
+{
+	mCommands.push_back(LRenderCommand());
+	LRenderCommand& command = mCommands.back();
+	command.type = type;
+	command.hasSrc = false;
+	command.hasDst = true;
+	command.texture = NULL;
+	return command;
+}
+
+void LCommandList::copy(SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect& dst)
+{
+	LRenderCommand& command = push(LRenderCommand::COPY);
+	command.texture = texture;
+	if (src != NULL)
+	{
+		command.hasSrc = true;
+		command.src = *src;
+	}
+	command.dst = dst;
+}
+
+void LCommandList::fillRect(const SDL_Rect& rect)
+{
+	LRenderCommand& command = push(LRenderCommand::FILL_RECT);
+	command.dst = rect;
+}
+
+void LCommandList::drawLine(int x1, int y1, int x2, int y2)
+{
+	LRenderCommand& command = push(LRenderCommand::LINE);
+	command.dst.x = x1;
+	command.dst.y = y1;
+	command.dst.w = x2;
+	command.dst.h = y2;
+}
+
+void LCommandList::drawPoint(int x, int y)
+{
+	LRenderCommand& command = push(LRenderCommand::POINT);
+	command.dst.x = x;
+	command.dst.y = y;
+}
+
+void LCommandList::setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+	LRenderCommand& command = push(LRenderCommand::DRAW_COLOR);
+	command.r = r;
+	command.g = g;
+	command.b = b;
+	command.a = a;
+}
+
+void LCommandList::setColorMod(SDL_Texture* texture, Uint8 r, Uint8 g, Uint8 b)
+{
+	LRenderCommand& command = push(LRenderCommand::COLOR_MOD);
+	command.texture = texture;
+	command.r = r;
+	command.g = g;
+	command.b = b;
+}
+
+void LCommandList::setViewport(const SDL_Rect* rect)
+{
+	LRenderCommand& command = push(LRenderCommand::VIEWPORT);
+	command.hasDst = rect != NULL;
+	if (rect != NULL)
+	{
+		command.dst = *rect;
+	}
+}
+
+void LCommandList::clearTarget()
+{
+	LRenderCommand& command = push(LRenderCommand::CLEAR);
+	command.hasDst = false;
+}
+
+void LCommandList::submit(SDL_Renderer* ren) const
+{
+	for (size_t i = 0; i < mCommands.size(); ++i)
+	{
+		const LRenderCommand& command = mCommands[i];
+		switch (command.type)
+		{
+		case LRenderCommand::COPY:
+			renderCopy(ren, command.texture, command.hasSrc ? &command.src : NULL, &command.dst);
+			break;
+		case LRenderCommand::FILL_RECT:
+			renderFillRect(ren, &command.dst);
+			break;
+		case LRenderCommand::LINE:
+			renderDrawLine(ren, command.dst.x, command.dst.y, command.dst.w, command.dst.h);
+			break;
+		case LRenderCommand::POINT:
+			renderDrawPoint(ren, command.dst.x, command.dst.y);
+			break;
+		case LRenderCommand::DRAW_COLOR:
+			renderSetDrawColor(ren, command.r, command.g, command.b, command.a);
+			break;
+		case LRenderCommand::COLOR_MOD:
+			renderSetTextureColorMod(command.texture, command.r, command.g, command.b);
+			break;
+		case LRenderCommand::VIEWPORT:
+			renderSetViewport(ren, command.hasDst ? &command.dst : NULL);
+			break;
+		case LRenderCommand::CLEAR:
+			renderClear(ren);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+size_t LCommandList::size() const
+{
+	return mCommands.size();
+}
+
+void LCommandList::submitAll(SDL_Renderer* ren, const LCommandList* lists, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		lists[i].submit(ren);
+	}
+}
+
+namespace
+{
+	struct RecordTask
+	{
+		LCommandList* lists;
+		int count;
+		LCommandList::RecordFunc func;
+		void* userdata;
+	};
+
+	void recordRange(int begin, int end, void* data)
+	{
+		RecordTask* task = (RecordTask*)data;
+		for (int i = begin; i < end; ++i)
+		{
+			task->func(task->lists[i], i, task->count, task->userdata);
+		}
+	}
+}
+
+void LCommandList::recordParallel(LCommandList* lists, int count, RecordFunc func, void* userdata)
+{
+	RecordTask task = { lists, count, func, userdata };
+	gJobSystem.parallelFor(count, 1, recordRange, &task);
+}
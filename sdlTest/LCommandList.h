@@ -0,0 +1,83 @@
+#pragma once
+
+#ifndef LCOMMANDLIST_H
+#define LCOMMANDLIST_H
+
+#include <vector>
+#include "SDL.h"
+
+//A single recorded draw call
+struct LRenderCommand
+{
+	enum Type
+	{
+		COPY,
+		FILL_RECT,
+		LINE,
+		POINT,
+		DRAW_COLOR,
+		COLOR_MOD,
+		VIEWPORT,
+		CLEAR
+	};
+
+	Uint8 type;
+	bool hasSrc;
+	bool hasDst;
+
+	//Draw color or color modulation
+	Uint8 r, g, b, a;
+
+	SDL_Texture* texture;
+	SDL_Rect src;
+
+	//Destination, fill area, viewport, or line end points as x1, y1, x2, y2
+	SDL_Rect dst;
+};
+
+//Draw commands recorded by one thread and submitted later on the render thread
+//Each list is written by a single thread so recording needs no locking
+class LCommandList
+{
+public:
+	//Records into list number index out of count lists
+	typedef void (*RecordFunc)(LCommandList& list, int index, int count, void* userdata);
+
+	//Initializes variables
+	LCommandList();
+
+	//Preallocates room for commands so steady state recording does not allocate
+	void reserve(size_t commands);
+
+	//Drops recorded commands but keeps the storage
+	void clear();
+
+	//Recording, mirrors the SDL calls of the same name
+	void copy(SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect& dst);
+	void fillRect(const SDL_Rect& rect);
+	void drawLine(int x1, int y1, int x2, int y2);
+	void drawPoint(int x, int y);
+	void setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+	void setColorMod(SDL_Texture* texture, Uint8 r, Uint8 g, Uint8 b);
+	void setViewport(const SDL_Rect* rect);
+
+	//Fills the target with the draw color, mirrors SDL_RenderClear
+	void clearTarget();
+
+	//Issues recorded commands in order, must be called on the render thread
+	void submit(SDL_Renderer* ren) const;
+
+	size_t size() const;
+
+	//Submits lists in index order so the result does not depend on thread timing
+	static void submitAll(SDL_Renderer* ren, const LCommandList* lists, int count);
+
+	//Runs func for every list on the job system, the calling thread included
+	static void recordParallel(LCommandList* lists, int count, RecordFunc func, void* userdata);
+
+private:
+	LRenderCommand& push(Uint8 type);
+
+	std::vector<LRenderCommand> mCommands;
+};
+#endif
@@ -0,0 +1,135 @@
+#include"LFrameArena.h"
+
+LFrameArena::LFrameArena()
+{
+	//Initialize
+	for (int i = 0; i < 2; ++i)
+	{
+		mPages[i].data = NULL;
+		mPages[i].size = 0;
+		mPages[i].used = 0;
+		mPages[i].overflowBytes = 0;
+	}
+	mCurrent = 0;
+	mHighWater = 0;
+	mFrameMallocs = 0;
+	mLastFrameMallocs = 0;
+	mTotalMallocs = 0;
+}
+
+LFrameArena::~LFrameArena()
+{
+	//Deallocate
+	for (int i = 0; i < 2; ++i)
+	{
+		Page& page = mPages[i];
+		for (size_t j = 0; j < page.overflow.size(); ++j)
+		{
+			SDL_free(page.overflow[j]);
+		}
+		SDL_free(page.data);
+	}
+}
+
+void LFrameArena::reserve(size_t bytesPerFrame)
+{
+	for (int i = 0; i < 2; ++i)
+	{
+		Page& page = mPages[i];
+		if (page.size < bytesPerFrame && page.used == 0)
+		{
+			SDL_free(page.data);
+			page.data = (Uint8*)SDL_malloc(bytesPerFrame);
+			page.size = page.data != NULL ? bytesPerFrame : 0;
+			++mTotalMallocs;
+		}
+	}
+}
+
+void* LFrameArena::allocate(size_t size, size_t align)
+{
+	Page& page = mPages[mCurrent];
+	size_t offset = (page.used + align - 1) & ~(align - 1);
+	if (page.data != NULL && offset + size <= page.size)
+	{
+		page.used = offset + size;
+		return page.data + offset;
+	}
+
+	//Out of room, take a heap block for now and grow the page when it is next reset
+	void* block = SDL_malloc(size + align);
+	if (block == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	page.overflow.push_back(block);
+	page.overflowBytes += size + align;
+	++mFrameMallocs;
+	++mTotalMallocs;
+	size_t address = ((size_t)block + align - 1) & ~(align - 1);
+	return (void*)address;
+}
+
+void LFrameArena::resetPage(Page& page)
+{
+	size_t needed = page.used + page.overflowBytes;
+	if (needed > mHighWater)
+	{
+		mHighWater = needed;
+	}
+
+	if (!page.overflow.empty())
+	{
+		for (size_t i = 0; i < page.overflow.size(); ++i)
+		{
+			SDL_free(page.overflow[i]);
+		}
+		page.overflow.clear();
+
+		//Grow with headroom so a slowly growing workload settles quickly
+		size_t size = needed + needed / 2;
+		SDL_free(page.data);
+		page.data = (Uint8*)SDL_malloc(size);
+		page.size = page.data != NULL ? size : 0;
+		++mFrameMallocs;
+		++mTotalMallocs;
+	}
+	page.used = 0;
+	page.overflowBytes = 0;
+}
+
+void LFrameArena::endFrame()
+{
+	mLastFrameMallocs = mFrameMallocs;
+	mFrameMallocs = 0;
+
+	//Record the finished page's usage but keep its data alive for one more frame
+	Page& finished = mPages[mCurrent];
+	if (finished.used + finished.overflowBytes > mHighWater)
+	{
+		mHighWater = finished.used + finished.overflowBytes;
+	}
+
+	mCurrent ^= 1;
+	resetPage(mPages[mCurrent]);
+}
+
+size_t LFrameArena::getUsed()
+{
+	return mPages[mCurrent].used + mPages[mCurrent].overflowBytes;
+}
+
+size_t LFrameArena::getHighWater()
+{
+	return mHighWater;
+}
+
+Uint32 LFrameArena::getFrameMallocs()
+{
+	return mLastFrameMallocs;
+}
+
+Uint32 LFrameArena::getTotalMallocs()
+{
+	return mTotalMallocs;
+}
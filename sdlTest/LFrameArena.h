@@ -0,0 +1,95 @@
+#pragma once
+
+#ifndef LFRAMEARENA_H
+#define LFRAMEARENA_H
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <vector>
+#include "SDL.h"
+
+//Bump allocator for data that lives one frame
+//Two pages alternate so data recorded in frame N stays valid until frame N + 1 has been submitted
+class LFrameArena
+{
+public:
+	//Initializes variables
+	LFrameArena();
+
+	//Deallocates both pages
+	~LFrameArena();
+
+	//Allocates the pages up front
+	void reserve(size_t bytesPerFrame);
+
+	//Allocates from the current frame, never returns NULL
+	void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+	//Switches pages, the page reused now was last written two frames ago
+	void endFrame();
+
+	//Bytes used by the frame in progress and the most used by any frame
+	size_t getUsed();
+	size_t getHighWater();
+
+	//Heap allocations made by the arena in the last finished frame and overall
+	Uint32 getFrameMallocs();
+	Uint32 getTotalMallocs();
+
+private:
+	struct Page
+	{
+		Uint8* data;
+		size_t size;
+		size_t used;
+
+		//Blocks that did not fit, freed when the page is reused
+		std::vector<void*> overflow;
+		size_t overflowBytes;
+	};
+
+	//Empties a page, growing it to hold everything the last frame on it needed
+	void resetPage(Page& page);
+
+	Page mPages[2];
+	int mCurrent;
+	size_t mHighWater;
+	Uint32 mFrameMallocs;
+	Uint32 mLastFrameMallocs;
+	Uint32 mTotalMallocs;
+};
+
+//STL allocator drawing from a frame arena, deallocation is a no-op
+template<typename T>
+class LFrameAllocator
+{
+public:
+	typedef T value_type;
+
+	explicit LFrameAllocator(LFrameArena& arena) : mArena(&arena) {}
+	template<typename U>
+	LFrameAllocator(const LFrameAllocator<U>& other) : mArena(other.getArena()) {}
+
+	T* allocate(size_t count)
+	{
+		return (T*)mArena->allocate(count * sizeof(T), alignof(T));
+	}
+	void deallocate(T*, size_t) {}
+
+	LFrameArena* getArena() const { return mArena; }
+
+	template<typename U>
+	bool operator==(const LFrameAllocator<U>& other) const { return mArena == other.getArena(); }
+	template<typename U>
+	bool operator!=(const LFrameAllocator<U>& other) const { return mArena != other.getArena(); }
+
+private:
+	LFrameArena* mArena;
+};
+
+//Containers whose storage is released wholesale at the end of the frame
+template<typename T>
+using LFrameVector = std::vector<T, LFrameAllocator<T> >;
+typedef std::basic_string<char, std::char_traits<char>, LFrameAllocator<char> > LFrameString;
+#endif
@@ -0,0 +1,290 @@
+#include"LFrameCapture.h"
+
+LFrameCapture::LFrameCapture()
+{
+	//Initialize
+	mFile = NULL;
+	mFormat = FORMAT_Y4M;
+	mWidth = 0;
+	mHeight = 0;
+	mReadIndex = 0;
+	mWriteIndex = 0;
+	mQueued = 0;
+	mThread = NULL;
+	mLock = NULL;
+	mFrameReady = NULL;
+	mRunning = false;
+	mCaptured = 0;
+	mWritten = 0;
+	mDropped = 0;
+	mTotalTicks = 0;
+	mMaxTicks = 0;
+}
+
+LFrameCapture::~LFrameCapture()
+{
+	//Deallocate
+	stop();
+}
+
+bool LFrameCapture::start(SDL_Renderer* ren, std::string path, Format format, int fps, int ringSize)
+{
+	//Finish any previous recording
+	stop();
+
+	if (SDL_GetRendererOutputSize(ren, &mWidth, &mHeight) != 0)
+	{
+		printf("Unable to query renderer output size! SDL Error: %s\n", SDL_GetError());
+		return false;
+	}
+
+	mFile = SDL_RWFromFile(path.c_str(), "wb");
+	if (mFile == NULL)
+	{
+		printf("Unable to open capture file %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+		return false;
+	}
+	mFormat = format;
+
+	//Y4M stream header, 4:2:0 chroma needs even dimensions
+	if (mFormat == FORMAT_Y4M)
+	{
+		mWidth &= ~1;
+		mHeight &= ~1;
+		char header[128];
+		int len = SDL_snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", mWidth, mHeight, fps);
+		SDL_RWwrite(mFile, header, 1, len);
+		mYUV.resize(mWidth * mHeight * 3 / 2);
+	}
+
+	//Allocate the whole ring up front so capturing never allocates
+	mRing.resize(ringSize < 2 ? 2 : ringSize);
+	for (size_t i = 0; i < mRing.size(); ++i)
+	{
+		mRing[i].resize(mWidth * mHeight * 4);
+	}
+	mReadIndex = 0;
+	mWriteIndex = 0;
+	mQueued = 0;
+	mCaptured = 0;
+	mWritten = 0;
+	mDropped = 0;
+	mTotalTicks = 0;
+	mMaxTicks = 0;
+
+	mLock = SDL_CreateMutex();
+	mFrameReady = SDL_CreateCond();
+	mRunning = true;
+	mThread = SDL_CreateThread(writerThread, "FrameCaptureWriter", this);
+	if (mThread == NULL)
+	{
+		printf("Unable to create capture writer thread! SDL Error: %s\n", SDL_GetError());
+		mRunning = false;
+		stop();
+		return false;
+	}
+	return true;
+}
+
+void LFrameCapture::stop()
+{
+	if (mThread != NULL)
+	{
+		//Let the writer drain the ring before exiting
+		SDL_LockMutex(mLock);
+		mRunning = false;
+		SDL_CondSignal(mFrameReady);
+		SDL_UnlockMutex(mLock);
+		SDL_WaitThread(mThread, NULL);
+		mThread = NULL;
+	}
+	if (mFrameReady != NULL)
+	{
+		SDL_DestroyCond(mFrameReady);
+		mFrameReady = NULL;
+	}
+	if (mLock != NULL)
+	{
+		SDL_DestroyMutex(mLock);
+		mLock = NULL;
+	}
+	if (mFile != NULL)
+	{
+		SDL_RWclose(mFile);
+		mFile = NULL;
+	}
+	mRing.clear();
+	mYUV.clear();
+}
+
+void LFrameCapture::captureFrame(SDL_Renderer* ren)
+{
+	if (mThread == NULL)
+	{
+		return;
+	}
+	Uint64 startTicks = SDL_GetPerformanceCounter();
+
+	//Claim a free slot, never wait for the writer
+	SDL_LockMutex(mLock);
+	bool full = mQueued == (int)mRing.size();
+	int slot = mWriteIndex;
+	SDL_UnlockMutex(mLock);
+
+	if (full)
+	{
+		++mDropped;
+	}
+	else
+	{
+		//Only the writer reads queued slots, so this one is ours until it is published
+		SDL_Rect area = { 0, 0, mWidth, mHeight };
+		if (SDL_RenderReadPixels(ren, &area, SDL_PIXELFORMAT_RGBA32, &mRing[slot][0], mWidth * 4) != 0)
+		{
+			printf("Unable to read frame pixels! SDL Error: %s\n", SDL_GetError());
+			++mDropped;
+		}
+		else
+		{
+			SDL_LockMutex(mLock);
+			mWriteIndex = (mWriteIndex + 1) % (int)mRing.size();
+			++mQueued;
+			SDL_CondSignal(mFrameReady);
+			SDL_UnlockMutex(mLock);
+			++mCaptured;
+		}
+	}
+
+	Uint64 ticks = SDL_GetPerformanceCounter() - startTicks;
+	mTotalTicks += ticks;
+	if (ticks > mMaxTicks)
+	{
+		mMaxTicks = ticks;
+	}
+}
+
+int LFrameCapture::writerThread(void* data)
+{
+	LFrameCapture* capture = (LFrameCapture*)data;
+
+	SDL_LockMutex(capture->mLock);
+	for (;;)
+	{
+		while (capture->mQueued == 0 && capture->mRunning)
+		{
+			SDL_CondWait(capture->mFrameReady, capture->mLock);
+		}
+		if (capture->mQueued == 0)
+		{
+			//Stopped and drained
+			break;
+		}
+		int slot = capture->mReadIndex;
+		SDL_UnlockMutex(capture->mLock);
+
+		//Convert and write outside the lock so the render thread is never held up by disk
+		bool written = capture->writeFrame(&capture->mRing[slot][0]);
+
+		SDL_LockMutex(capture->mLock);
+		capture->mReadIndex = (capture->mReadIndex + 1) % (int)capture->mRing.size();
+		--capture->mQueued;
+		if (written)
+		{
+			++capture->mWritten;
+		}
+	}
+	SDL_UnlockMutex(capture->mLock);
+	return 0;
+}
+
+bool LFrameCapture::writeFrame(const Uint8* pixels)
+{
+	if (mFormat == FORMAT_RGBA)
+	{
+		size_t size = mWidth * mHeight * 4;
+		return SDL_RWwrite(mFile, pixels, 1, size) == size;
+	}
+
+	convertToYUV(pixels);
+	static const char frameHeader[] = "FRAME\n";
+	SDL_RWwrite(mFile, frameHeader, 1, sizeof(frameHeader) - 1);
+	return SDL_RWwrite(mFile, &mYUV[0], 1, mYUV.size()) == mYUV.size();
+}
+
+void LFrameCapture::convertToYUV(const Uint8* pixels)
+{
+	//Full range BT.601 in 8 bit fixed point, matching the C420jpeg tag
+	Uint8* yPlane = &mYUV[0];
+	Uint8* uPlane = yPlane + mWidth * mHeight;
+	Uint8* vPlane = uPlane + (mWidth / 2) * (mHeight / 2);
+	int pitch = mWidth * 4;
+
+	for (int y = 0; y < mHeight; y += 2)
+	{
+		const Uint8* row0 = pixels + y * pitch;
+		const Uint8* row1 = row0 + pitch;
+		Uint8* y0 = yPlane + y * mWidth;
+		Uint8* y1 = y0 + mWidth;
+		for (int x = 0; x < mWidth; x += 2)
+		{
+			const Uint8* p[4] = { row0 + x * 4, row0 + x * 4 + 4, row1 + x * 4, row1 + x * 4 + 4 };
+			int r = 0, g = 0, b = 0;
+			for (int i = 0; i < 4; ++i)
+			{
+				r += p[i][0];
+				g += p[i][1];
+				b += p[i][2];
+			}
+			y0[x] = (Uint8)((77 * p[0][0] + 150 * p[0][1] + 29 * p[0][2] + 128) >> 8);
+			y0[x + 1] = (Uint8)((77 * p[1][0] + 150 * p[1][1] + 29 * p[1][2] + 128) >> 8);
+			y1[x] = (Uint8)((77 * p[2][0] + 150 * p[2][1] + 29 * p[2][2] + 128) >> 8);
+			y1[x + 1] = (Uint8)((77 * p[3][0] + 150 * p[3][1] + 29 * p[3][2] + 128) >> 8);
+
+			//Chroma from the average of the 2x2 block
+			int u = ((-43 * r - 85 * g + 128 * b) >> 2) + (128 << 8);
+			int v = ((128 * r - 107 * g - 21 * b) >> 2) + (128 << 8);
+			int index = (y / 2) * (mWidth / 2) + x / 2;
+			uPlane[index] = (Uint8)SDL_max(0, SDL_min((u + 128) >> 8, 255));
+			vPlane[index] = (Uint8)SDL_max(0, SDL_min((v + 128) >> 8, 255));
+		}
+	}
+}
+
+void LFrameCapture::printStats()
+{
+	Uint32 frames = mCaptured + mDropped;
+	double freq = (double)SDL_GetPerformanceFrequency();
+	double avgMs = frames > 0 ? mTotalTicks * 1000.0 / freq / frames : 0.0;
+	double maxMs = mMaxTicks * 1000.0 / freq;
+
+	Uint32 written = mWritten;
+	if (mLock != NULL)
+	{
+		SDL_LockMutex(mLock);
+		written = mWritten;
+		SDL_UnlockMutex(mLock);
+	}
+
+	printf("Capture: %u captured, %u written, %u dropped, overhead avg %.3f ms max %.3f ms\n",
+		mCaptured, written, mDropped, avgMs, maxMs);
+}
+
+bool LFrameCapture::isCapturing()
+{
+	return mThread != NULL;
+}
+
+Uint32 LFrameCapture::getCapturedFrames()
+{
+	return mCaptured;
+}
+
+Uint32 LFrameCapture::getWrittenFrames()
+{
+	return mWritten;
+}
+
+Uint32 LFrameCapture::getDroppedFrames()
+{
+	return mDropped;
+}
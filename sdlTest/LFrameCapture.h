@@ -0,0 +1,87 @@
+#pragma once
+
+#ifndef LFRAMECAPTURE_H
+#define LFRAMECAPTURE_H
+
+#include <iostream>
+#include <vector>
+#include "SDL.h"
+
+//Records rendered frames to disk without blocking the frame loop
+class LFrameCapture
+{
+public:
+	//Output file formats
+	enum Format
+	{
+		FORMAT_Y4M,
+		FORMAT_RGBA
+	};
+
+	//Initializes variables
+	LFrameCapture();
+
+	//Stops the writer and closes the output file
+	~LFrameCapture();
+
+	//Opens the output file, allocates the frame ring and starts the writer thread
+	bool start(SDL_Renderer* ren, std::string path, Format format = FORMAT_Y4M, int fps = 60, int ringSize = 8);
+
+	//Flushes queued frames, stops the writer thread and closes the output file
+	void stop();
+
+	//Reads the current back buffer into a free ring slot, drops the frame if the writer is behind
+	//Must be called after drawing and before SDL_RenderPresent
+	void captureFrame(SDL_Renderer* ren);
+
+	//Prints frame counters and per frame capture overhead
+	void printStats();
+
+	bool isCapturing();
+
+	//Frame counters
+	Uint32 getCapturedFrames();
+	Uint32 getWrittenFrames();
+	Uint32 getDroppedFrames();
+
+private:
+	static int writerThread(void* data);
+
+	//Writes one RGBA frame in the output format
+	bool writeFrame(const Uint8* pixels);
+
+	//Converts RGBA pixels to planar 4:2:0 YUV
+	void convertToYUV(const Uint8* pixels);
+
+	//Output file
+	SDL_RWops* mFile;
+	Format mFormat;
+
+	//Frame dimensions
+	int mWidth;
+	int mHeight;
+
+	//Ring of preallocated RGBA frames, the writer consumes from mReadIndex
+	std::vector<std::vector<Uint8> > mRing;
+	int mReadIndex;
+	int mWriteIndex;
+	int mQueued;
+
+	//YUV planes used by the writer thread
+	std::vector<Uint8> mYUV;
+
+	SDL_Thread* mThread;
+	SDL_mutex* mLock;
+	SDL_cond* mFrameReady;
+	bool mRunning;
+
+	//Counters
+	Uint32 mCaptured;
+	Uint32 mWritten;
+	Uint32 mDropped;
+
+	//Capture overhead on the render thread in performance counter ticks
+	Uint64 mTotalTicks;
+	Uint64 mMaxTicks;
+};
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef LHANDLE_H
+#define LHANDLE_H
+
+#include "SDL.h"
+#include "SDL_ttf.h"
+#include "LMemoryTracker.h"
+
+/*
+ * Move-only owner of an SDL object. The deleter is part of the type rather
+ * than stored in the handle, so a handle is exactly the size of the raw
+ * pointer and every operation compiles down to plain pointer moves.
+ * NULL handles are allowed and destroying one does nothing.
+ */
+template<typename T, void (SDLCALL *Deleter)(T*)>
+class LHandle
+{
+public:
+	LHandle() : mPointer(NULL) {}
+	explicit LHandle(T* pointer) : mPointer(pointer) {}
+	~LHandle() { reset(); }
+
+	//Ownership can be moved but never shared
+	LHandle(LHandle&& other) noexcept : mPointer(other.mPointer) { other.mPointer = NULL; }
+	LHandle& operator=(LHandle&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset(other.mPointer);
+			other.mPointer = NULL;
+		}
+		return *this;
+	}
+	LHandle(const LHandle&) = delete;
+	LHandle& operator=(const LHandle&) = delete;
+
+	//Destroys the owned object and takes ownership of pointer
+	void reset(T* pointer = NULL)
+	{
+		T* old = mPointer;
+		mPointer = pointer;
+		if (old != NULL)
+		{
+			Deleter(old);
+		}
+	}
+
+	//Gives up ownership without destroying the object
+	T* release()
+	{
+		T* pointer = mPointer;
+		mPointer = NULL;
+		return pointer;
+	}
+
+	T* get() const { return mPointer; }
+	explicit operator bool() const { return mPointer != NULL; }
+
+private:
+	T* mPointer;
+};
+
+typedef LHandle<SDL_Window, SDL_DestroyWindow> LWindowHandle;
+typedef LHandle<SDL_Renderer, SDL_DestroyRenderer> LRendererHandle;
+typedef LHandle<SDL_Texture, destroyTrackedTexture> LTextureHandle;
+typedef LHandle<SDL_Surface, freeTrackedSurface> LSurfaceHandle;
+typedef LHandle<TTF_Font, closeTrackedFont> LFontHandle;
+
+static_assert(sizeof(LTextureHandle) == sizeof(SDL_Texture*), "handles must be pointer sized");
+static_assert(sizeof(LFontHandle) == sizeof(TTF_Font*), "handles must be pointer sized");
+#endif
@@ -0,0 +1,224 @@
+#include"LHud.h"
+#include"LMemoryTracker.h"
+#include"LAssetArchive.h"
+
+#include <stdio.h>
+
+//Graph height in pixels and the frame time it represents
+static const int GRAPH_HEIGHT = 40;
+static const float GRAPH_MAX_MS = 33.3f;
+
+LHud::LHud()
+{
+	//Initialize
+	mLineHeight = 0;
+	mVisible = false;
+	for (int i = 0; i < GRAPH_FRAMES; ++i)
+	{
+		mFrameTimes[i] = 0.0f;
+	}
+	mFrameIndex = 0;
+	mFrameCount = 0;
+	mLastFrame = 0;
+	SDL_zero(mStats);
+	SDL_zero(mGlyphRects);
+	mHudMs = 0.0;
+	mHudDrawCalls = 0;
+}
+
+bool LHud::create(SDL_Renderer* ren, std::string fontFile, int fontSize)
+{
+	SDL_RWops* file = gAssetArchive.openFile(fontFile);
+	if (file == NULL)
+	{
+		printf("Unable to open HUD font %s! SDL Error: %s\n", fontFile.c_str(), SDL_GetError());
+		return false;
+	}
+	return create(ren, file, fontSize);
+}
+
+bool LHud::create(SDL_Renderer* ren, SDL_RWops* fontFile, int fontSize)
+{
+	//Get rid of preexisting atlas
+	free();
+
+	LFontHandle font(TTF_OpenFontRW(fontFile, 1, fontSize));
+	if (!font)
+	{
+		printf("Unable to open HUD font! SDL_ttf Error: %s\n", TTF_GetError());
+		return false;
+	}
+	LMEMORY_TRACK_FONT(font.get(), "HUD font", 0);
+
+	//Each glyph is rendered as a one character run so its cell already includes bearing and advance
+	SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+	LSurfaceHandle cells[95];
+	int atlasWidth = 0;
+	mLineHeight = TTF_FontHeight(font.get());
+	for (int i = 0; i < 95; ++i)
+	{
+		char text[2] = { (char)(32 + i), '\0' };
+		cells[i].reset(TTF_RenderText_Blended(font.get(), text, white));
+		if (cells[i])
+		{
+			atlasWidth += cells[i].get()->w;
+		}
+	}
+
+	LSurfaceHandle atlas(SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, mLineHeight, 32, SDL_PIXELFORMAT_ARGB8888));
+	if (!atlas)
+	{
+		printf("Unable to create HUD glyph atlas! SDL Error: %s\n", SDL_GetError());
+		return false;
+	}
+	int x = 0;
+	for (int i = 0; i < 95; ++i)
+	{
+		SDL_Rect& rect = mGlyphRects[i];
+		rect.x = x;
+		rect.y = 0;
+		rect.w = cells[i] ? cells[i].get()->w : 0;
+		rect.h = cells[i] ? SDL_min(cells[i].get()->h, mLineHeight) : 0;
+		if (cells[i])
+		{
+			SDL_SetSurfaceBlendMode(cells[i].get(), SDL_BLENDMODE_NONE);
+			SDL_BlitSurface(cells[i].get(), NULL, atlas.get(), &rect);
+		}
+		x += rect.w;
+	}
+
+	mGlyphs.reset(SDL_CreateTextureFromSurface(ren, atlas.get()));
+	if (!mGlyphs)
+	{
+		printf("Unable to create HUD glyph texture! SDL Error: %s\n", SDL_GetError());
+		return false;
+	}
+	LMEMORY_TRACK_TEXTURE(mGlyphs.get(), "HUD glyphs");
+	return true;
+}
+
+void LHud::free()
+{
+	mGlyphs.reset();
+}
+
+void LHud::toggle()
+{
+	mVisible = !mVisible;
+}
+
+bool LHud::isVisible()
+{
+	return mVisible;
+}
+
+int LHud::drawText(SDL_Renderer* ren, int x, int y, const char* text)
+{
+	int glyphs = 0;
+	for (const char* c = text; *c != '\0'; ++c)
+	{
+		int index = *c - 32;
+		if (index < 0 || index >= 95)
+		{
+			continue;
+		}
+		const SDL_Rect& src = mGlyphRects[index];
+		SDL_Rect dst = { x, y, src.w, src.h };
+		SDL_RenderCopy(ren, mGlyphs.get(), &src, &dst);
+		x += src.w;
+		++glyphs;
+	}
+	return glyphs;
+}
+
+void LHud::render(SDL_Renderer* ren)
+{
+	if (!mVisible || !mGlyphs)
+	{
+		return;
+	}
+	Uint64 start = SDL_GetPerformanceCounter();
+	Uint32 drawCalls = 0;
+
+	//Draw over the whole target and put everything back afterwards
+	SDL_Rect oldViewport;
+	Uint8 oldR, oldG, oldB, oldA;
+	SDL_BlendMode oldBlend;
+	SDL_RenderGetViewport(ren, &oldViewport);
+	SDL_GetRenderDrawColor(ren, &oldR, &oldG, &oldB, &oldA);
+	SDL_GetRenderDrawBlendMode(ren, &oldBlend);
+	SDL_RenderSetViewport(ren, NULL);
+
+	//Averages over the graph window
+	float lastMs = mFrameTimes[(mFrameIndex + GRAPH_FRAMES - 1) % GRAPH_FRAMES];
+	float totalMs = 0.0f;
+	float worstMs = 0.0f;
+	for (int i = 0; i < mFrameCount; ++i)
+	{
+		float ms = mFrameTimes[(mFrameIndex + GRAPH_FRAMES - 1 - i) % GRAPH_FRAMES];
+		totalMs += ms;
+		worstMs = SDL_max(worstMs, ms);
+	}
+	float averageMs = mFrameCount > 0 ? totalMs / mFrameCount : 0.0f;
+
+	char lines[6][96];
+	SDL_snprintf(lines[0], sizeof(lines[0]), "FPS %.1f  avg %.1f", lastMs > 0.0f ? 1000.0f / lastMs : 0.0f, averageMs > 0.0f ? 1000.0f / averageMs : 0.0f);
+	SDL_snprintf(lines[1], sizeof(lines[1]), "Frame %.2f ms  worst %.2f ms", lastMs, worstMs);
+	SDL_snprintf(lines[2], sizeof(lines[2]), "Draws %u  texture switches %u", mStats.drawCalls, mStats.textureSwitches);
+	SDL_snprintf(lines[3], sizeof(lines[3]), "State changes %u  elided %u", mStats.stateChanges, mStats.elidedStateChanges);
+	SDL_snprintf(lines[4], sizeof(lines[4]), "Texture memory %.2f MB", mStats.textureBytes / (1024.0 * 1024.0));
+	SDL_snprintf(lines[5], sizeof(lines[5]), "HUD %.3f ms  %u draws", mHudMs, mHudDrawCalls);
+
+	//Translucent backing panel
+	SDL_Rect panel = { 4, 4, GRAPH_FRAMES * 2 + 120, 6 * mLineHeight + GRAPH_HEIGHT + 12 };
+	SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+	SDL_SetRenderDrawColor(ren, 0x00, 0x00, 0x00, 0xB0);
+	SDL_RenderFillRect(ren, &panel);
+	++drawCalls;
+
+	for (int i = 0; i < 6; ++i)
+	{
+		drawCalls += drawText(ren, 8, 6 + i * mLineHeight, lines[i]);
+	}
+
+	//Frame time graph, oldest on the left, in one call
+	SDL_Rect bars[GRAPH_FRAMES];
+	int graphTop = 8 + 6 * mLineHeight;
+	for (int i = 0; i < GRAPH_FRAMES; ++i)
+	{
+		float ms = mFrameTimes[(mFrameIndex + i) % GRAPH_FRAMES];
+		int height = (int)(SDL_min(ms / GRAPH_MAX_MS, 1.0f) * GRAPH_HEIGHT);
+		bars[i].x = 8 + i * 2;
+		bars[i].y = graphTop + GRAPH_HEIGHT - height;
+		bars[i].w = 2;
+		bars[i].h = height;
+	}
+	SDL_SetRenderDrawColor(ren, 0x40, 0xFF, 0x40, 0xFF);
+	SDL_RenderFillRects(ren, bars, GRAPH_FRAMES);
+
+	//16.7 ms budget line
+	int budgetY = graphTop + GRAPH_HEIGHT - (int)(16.7f / GRAPH_MAX_MS * GRAPH_HEIGHT);
+	SDL_SetRenderDrawColor(ren, 0xFF, 0x40, 0x40, 0xFF);
+	SDL_RenderDrawLine(ren, 8, budgetY, 8 + GRAPH_FRAMES * 2, budgetY);
+	drawCalls += 2;
+
+	SDL_RenderSetViewport(ren, &oldViewport);
+	SDL_SetRenderDrawColor(ren, oldR, oldG, oldB, oldA);
+	SDL_SetRenderDrawBlendMode(ren, oldBlend);
+
+	mHudDrawCalls = drawCalls;
+	mHudMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void LHud::endFrame(const LHudStats& stats)
+{
+	Uint64 now = SDL_GetPerformanceCounter();
+	if (mLastFrame != 0)
+	{
+		mFrameTimes[mFrameIndex] = (float)((now - mLastFrame) * 1000.0 / SDL_GetPerformanceFrequency());
+		mFrameIndex = (mFrameIndex + 1) % GRAPH_FRAMES;
+		mFrameCount = SDL_min(mFrameCount + 1, GRAPH_FRAMES);
+	}
+	mLastFrame = now;
+	mStats = stats;
+}
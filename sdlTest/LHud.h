@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef LHUD_H
+#define LHUD_H
+
+#include <iostream>
+#include "SDL.h"
+#include "LHandle.h"
+
+//Per frame numbers shown by the HUD
+struct LHudStats
+{
+	Uint32 drawCalls;
+	Uint32 textureSwitches;
+	Uint32 stateChanges;
+	Uint32 elidedStateChanges;
+	size_t textureBytes;
+};
+
+//Performance overlay drawn from a prebuilt glyph atlas
+//Draws with raw SDL calls so it does not show up in the counters it displays
+class LHud
+{
+public:
+	//Frames kept for averages and the frame time graph
+	static const int GRAPH_FRAMES = 120;
+
+	//Initializes variables
+	LHud();
+
+	//Rasterizes printable ASCII from the font into one texture
+	bool create(SDL_Renderer* ren, std::string fontFile, int fontSize);
+
+	//Same from an opened font file, which is closed afterwards
+	bool create(SDL_Renderer* ren, SDL_RWops* fontFile, int fontSize);
+
+	//Deallocates the glyph atlas
+	void free();
+
+	//Shows or hides the overlay
+	void toggle();
+	bool isVisible();
+
+	//Draws the overlay with the last finished frame's numbers, call before presenting
+	void render(SDL_Renderer* ren);
+
+	//Records the time since the previous call and the counters of the frame that just ended
+	void endFrame(const LHudStats& stats);
+
+private:
+	//Draws one line of ASCII text, returns the number of glyphs drawn
+	int drawText(SDL_Renderer* ren, int x, int y, const char* text);
+
+	//Glyph atlas for characters 32 to 126
+	LTextureHandle mGlyphs;
+	SDL_Rect mGlyphRects[95];
+	int mLineHeight;
+
+	bool mVisible;
+
+	//Frame times in milliseconds, mFrameIndex is the oldest
+	float mFrameTimes[GRAPH_FRAMES];
+	int mFrameIndex;
+	int mFrameCount;
+	Uint64 mLastFrame;
+
+	LHudStats mStats;
+
+	//Cost of the last overlay draw
+	double mHudMs;
+	Uint32 mHudDrawCalls;
+};
+#endif
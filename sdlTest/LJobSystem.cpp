@@ -0,0 +1,456 @@
+#include"LJobSystem.h"
+
+#include <stdio.h>
+
+LJobSystem gJobSystem;
+
+thread_local int LJobSystem::sThreadIndex = -1;
+
+//Failed steal rounds before an idle worker sleeps
+static const int IDLE_SPINS = 256;
+
+LJobSystem::LJobSystem()
+{
+	//Initialize
+	SDL_AtomicSet(&mQuit, 0);
+	SDL_AtomicSet(&mNextDeque, 0);
+	SDL_AtomicSet(&mSleeping, 0);
+	SDL_AtomicSet(&mPendingCount, 0);
+	SDL_AtomicSet(&mMainCount, 0);
+	mWake = SDL_CreateSemaphore(0);
+	mPendingLock = SDL_CreateMutex();
+	mMainLock = SDL_CreateMutex();
+	mStatsStart = 0;
+}
+
+LJobSystem::~LJobSystem()
+{
+	//Deallocate
+	stop();
+	SDL_DestroyMutex(mMainLock);
+	SDL_DestroyMutex(mPendingLock);
+	SDL_DestroySemaphore(mWake);
+}
+
+bool LJobSystem::start(int workers)
+{
+	stop();
+	workers = SDL_max(0, workers);
+
+	//Workers first, the main thread's deque last
+	for (int i = 0; i <= workers; ++i)
+	{
+		Deque* deque = new Deque();
+		deque->lock = 0;
+		deque->top = 0;
+		deque->bottom = 0;
+		SDL_AtomicSet(&deque->size, 0);
+		SDL_zero(deque->stats);
+		mDeques.push_back(deque);
+	}
+	sThreadIndex = workers;
+	SDL_AtomicSet(&mQuit, 0);
+	mStatsStart = SDL_GetPerformanceCounter();
+
+	//Worker records must not move once threads point at them
+	mWorkers.resize(workers);
+	for (int i = 0; i < workers; ++i)
+	{
+		mWorkers[i].system = this;
+		mWorkers[i].index = i;
+		SDL_Thread* thread = SDL_CreateThread(workerThread, "JobWorker", &mWorkers[i]);
+		if (thread == NULL)
+		{
+			printf("Unable to create job worker! SDL Error: %s\n", SDL_GetError());
+			return false;
+		}
+		mThreads.push_back(thread);
+	}
+	return true;
+}
+
+void LJobSystem::stop()
+{
+	if (mDeques.empty())
+	{
+		return;
+	}
+
+	//Workers empty the deques before they exit
+	pumpMainThread();
+
+	SDL_AtomicSet(&mQuit, 1);
+	for (size_t i = 0; i < mThreads.size(); ++i)
+	{
+		SDL_SemPost(mWake);
+	}
+	for (size_t i = 0; i < mThreads.size(); ++i)
+	{
+		SDL_WaitThread(mThreads[i], NULL);
+	}
+	mThreads.clear();
+	mWorkers.clear();
+
+	for (size_t i = 0; i < mDeques.size(); ++i)
+	{
+		delete mDeques[i];
+	}
+	mDeques.clear();
+	sThreadIndex = -1;
+}
+
+int LJobSystem::getWorkerCount()
+{
+	return (int)mThreads.size();
+}
+
+int LJobSystem::self()
+{
+	return sThreadIndex >= 0 && sThreadIndex < (int)mDeques.size() ? sThreadIndex : -1;
+}
+
+bool LJobSystem::push(const LJob& job)
+{
+	//Outside threads spread their jobs over every deque
+	int index = self();
+	if (index < 0)
+	{
+		index = (int)((Uint32)SDL_AtomicAdd(&mNextDeque, 1) % mDeques.size());
+	}
+
+	Deque* deque = mDeques[index];
+	SDL_AtomicLock(&deque->lock);
+	bool pushed = deque->bottom - deque->top < (Uint32)DEQUE_SIZE;
+	if (pushed)
+	{
+		deque->jobs[deque->bottom & (DEQUE_SIZE - 1)] = job;
+		++deque->bottom;
+		SDL_AtomicAdd(&deque->size, 1);
+	}
+	SDL_AtomicUnlock(&deque->lock);
+
+	if (pushed && SDL_AtomicGet(&mSleeping) > 0)
+	{
+		SDL_SemPost(mWake);
+	}
+	return pushed;
+}
+
+bool LJobSystem::next(int self, LJob& job, bool& stolen)
+{
+	//Newest own job first, it is the most likely to be in cache
+	if (self >= 0)
+	{
+		Deque* deque = mDeques[self];
+		SDL_AtomicLock(&deque->lock);
+		bool found = deque->bottom != deque->top;
+		if (found)
+		{
+			--deque->bottom;
+			job = deque->jobs[deque->bottom & (DEQUE_SIZE - 1)];
+			SDL_AtomicAdd(&deque->size, -1);
+		}
+		SDL_AtomicUnlock(&deque->lock);
+		if (found)
+		{
+			stolen = false;
+			return true;
+		}
+	}
+
+	//Oldest job of the next deque that has one
+	int count = (int)mDeques.size();
+	int start = self >= 0 ? self + 1 : 0;
+	for (int i = 0; i < count; ++i)
+	{
+		//Skip empty deques without taking their lock
+		Deque* deque = mDeques[(start + i) % count];
+		if (SDL_AtomicGet(&deque->size) == 0)
+		{
+			continue;
+		}
+		SDL_AtomicLock(&deque->lock);
+		bool found = deque->bottom != deque->top;
+		if (found)
+		{
+			job = deque->jobs[deque->top & (DEQUE_SIZE - 1)];
+			++deque->top;
+			SDL_AtomicAdd(&deque->size, -1);
+		}
+		SDL_AtomicUnlock(&deque->lock);
+		if (found)
+		{
+			stolen = true;
+			return true;
+		}
+	}
+	return false;
+}
+
+void LJobSystem::execute(int self, const LJob& job, bool stolen)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	job.func(job.data);
+	if (self >= 0)
+	{
+		LJobStats& stats = mDeques[self]->stats;
+		stats.busyTicks += SDL_GetPerformanceCounter() - start;
+		++stats.jobs;
+		if (stolen)
+		{
+			++stats.steals;
+		}
+	}
+	finish(job.counter);
+}
+
+void LJobSystem::finish(LJobCounter* counter)
+{
+	if (counter == NULL || !SDL_AtomicDecRef(&counter->value) || SDL_AtomicGet(&mPendingCount) == 0)
+	{
+		return;
+	}
+
+	//Counter reached zero, release what was waiting on it
+	std::vector<LJob> ready;
+	SDL_LockMutex(mPendingLock);
+	for (size_t i = 0; i < mPending.size();)
+	{
+		if (SDL_AtomicGet(&mPending[i].dependency->value) == 0)
+		{
+			ready.push_back(mPending[i].job);
+			mPending[i] = mPending.back();
+			mPending.pop_back();
+		}
+		else
+		{
+			++i;
+		}
+	}
+	SDL_AtomicSet(&mPendingCount, (int)mPending.size());
+	SDL_UnlockMutex(mPendingLock);
+
+	for (size_t i = 0; i < ready.size(); ++i)
+	{
+		if (!push(ready[i]))
+		{
+			execute(self(), ready[i], false);
+		}
+	}
+}
+
+void LJobSystem::run(LJobFunc func, void* data, LJobCounter* counter, LJobCounter* dependency)
+{
+	LJob job = { func, data, counter };
+	if (counter != NULL)
+	{
+		SDL_AtomicIncRef(&counter->value);
+	}
+
+	if (dependency != NULL && SDL_AtomicGet(&dependency->value) > 0)
+	{
+		//Published before the dependency is checked again, so finish() either sees the count or we see zero
+		SDL_LockMutex(mPendingLock);
+		Pending pending = { job, dependency };
+		mPending.push_back(pending);
+		SDL_AtomicSet(&mPendingCount, (int)mPending.size());
+		bool held = SDL_AtomicGet(&dependency->value) > 0;
+		if (!held)
+		{
+			mPending.pop_back();
+			SDL_AtomicSet(&mPendingCount, (int)mPending.size());
+		}
+		SDL_UnlockMutex(mPendingLock);
+		if (held)
+		{
+			return;
+		}
+	}
+
+	//No workers or a full deque, run it here
+	if (mDeques.empty() || !push(job))
+	{
+		execute(self(), job, false);
+	}
+}
+
+void LJobSystem::wait(LJobCounter* counter)
+{
+	int index = self();
+	bool mainThread = !mDeques.empty() && index == (int)mDeques.size() - 1;
+	while (SDL_AtomicGet(&counter->value) > 0)
+	{
+		if (mainThread)
+		{
+			pumpMainThread();
+		}
+
+		LJob job;
+		bool stolen = false;
+		if (!mDeques.empty() && next(index, job, stolen))
+		{
+			execute(index, job, stolen);
+		}
+		else
+		{
+			//Whatever is left runs on another thread
+			SDL_Delay(0);
+		}
+	}
+}
+
+namespace
+{
+	struct ParallelFor
+	{
+		LJobSystem::RangeFunc func;
+		void* data;
+		int count;
+		int grain;
+		SDL_atomic_t next;
+	};
+
+	//Each job keeps claiming chunks, so uneven chunks balance out
+	void parallelForJob(void* data)
+	{
+		ParallelFor* loop = (ParallelFor*)data;
+		for (;;)
+		{
+			int begin = SDL_AtomicAdd(&loop->next, loop->grain);
+			if (begin >= loop->count)
+			{
+				break;
+			}
+			loop->func(begin, SDL_min(begin + loop->grain, loop->count), loop->data);
+		}
+	}
+}
+
+void LJobSystem::parallelFor(int count, int grain, RangeFunc func, void* data)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	grain = SDL_max(1, grain);
+
+	//The loop state lives on this stack until wait() returns
+	ParallelFor loop;
+	loop.func = func;
+	loop.data = data;
+	loop.count = count;
+	loop.grain = grain;
+	SDL_AtomicSet(&loop.next, 0);
+
+	int chunks = (count + grain - 1) / grain;
+	int jobs = SDL_min(chunks, (int)mDeques.size());
+	LJobCounter counter;
+	SDL_AtomicSet(&counter.value, 0);
+	for (int i = 1; i < jobs; ++i)
+	{
+		run(parallelForJob, &loop, &counter);
+	}
+	parallelForJob(&loop);
+	wait(&counter);
+}
+
+void LJobSystem::runOnMainThread(LJobFunc func, void* data, LJobCounter* counter)
+{
+	LJob job = { func, data, counter };
+	if (counter != NULL)
+	{
+		SDL_AtomicIncRef(&counter->value);
+	}
+	SDL_LockMutex(mMainLock);
+	mMainJobs.push_back(job);
+	SDL_AtomicIncRef(&mMainCount);
+	SDL_UnlockMutex(mMainLock);
+}
+
+void LJobSystem::pumpMainThread()
+{
+	if (SDL_AtomicGet(&mMainCount) == 0)
+	{
+		return;
+	}
+
+	//Jobs queued while running wait for the next pump
+	SDL_LockMutex(mMainLock);
+	mMainRunning.swap(mMainJobs);
+	SDL_AtomicSet(&mMainCount, 0);
+	SDL_UnlockMutex(mMainLock);
+
+	for (size_t i = 0; i < mMainRunning.size(); ++i)
+	{
+		execute(self(), mMainRunning[i], false);
+	}
+	mMainRunning.clear();
+}
+
+LJobStats LJobSystem::getStats(int thread)
+{
+	LJobStats stats;
+	SDL_zero(stats);
+	if (thread >= 0 && thread < (int)mDeques.size())
+	{
+		stats = mDeques[thread]->stats;
+	}
+	return stats;
+}
+
+void LJobSystem::resetStats()
+{
+	for (size_t i = 0; i < mDeques.size(); ++i)
+	{
+		SDL_zero(mDeques[i]->stats);
+	}
+	mStatsStart = SDL_GetPerformanceCounter();
+}
+
+void LJobSystem::printStats()
+{
+	Uint64 elapsed = SDL_GetPerformanceCounter() - mStatsStart;
+	printf("Job system, %d workers, %.1f ms sampled:\n", getWorkerCount(), elapsed * 1000.0 / SDL_GetPerformanceFrequency());
+	for (size_t i = 0; i < mDeques.size(); ++i)
+	{
+		const LJobStats& stats = mDeques[i]->stats;
+		printf("  %-8s %2d  busy %5.1f%%  jobs %8u  steals %8u\n", i + 1 < mDeques.size() ? "worker" : "main", (int)i,
+			elapsed > 0 ? stats.busyTicks * 100.0 / elapsed : 0.0, stats.jobs, stats.steals);
+	}
+}
+
+int SDLCALL LJobSystem::workerThread(void* data)
+{
+	Worker* worker = (Worker*)data;
+	LJobSystem* system = worker->system;
+	int index = worker->index;
+	sThreadIndex = index;
+
+	int idle = 0;
+	for (;;)
+	{
+		LJob job;
+		bool stolen = false;
+		if (system->next(index, job, stolen))
+		{
+			system->execute(index, job, stolen);
+			idle = 0;
+			continue;
+		}
+		if (SDL_AtomicGet(&system->mQuit) != 0)
+		{
+			break;
+		}
+
+		//Nothing anywhere for a while, sleep until a push or a short timeout
+		if (++idle < IDLE_SPINS)
+		{
+			continue;
+		}
+		SDL_AtomicIncRef(&system->mSleeping);
+		SDL_SemWaitTimeout(system->mWake, 1);
+		SDL_AtomicAdd(&system->mSleeping, -1);
+		idle = 0;
+	}
+	return 0;
+}
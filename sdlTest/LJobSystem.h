@@ -0,0 +1,148 @@
+#pragma once
+
+#ifndef LJOBSYSTEM_H
+#define LJOBSYSTEM_H
+
+#include <vector>
+#include "SDL.h"
+
+//Job entry point
+typedef void (*LJobFunc)(void* data);
+
+//Number of unfinished jobs, zero once they all ran
+struct LJobCounter
+{
+	SDL_atomic_t value;
+};
+
+//One job, copied into the queues by value
+struct LJob
+{
+	LJobFunc func;
+	void* data;
+	LJobCounter* counter;
+};
+
+//Per thread scheduling numbers since the last resetStats()
+struct LJobStats
+{
+	Uint64 busyTicks;
+	Uint32 jobs;
+	Uint32 steals;
+};
+
+//Work stealing job system, one deque per worker plus one for the main thread
+//Any thread may submit; waiting threads run jobs instead of blocking
+class LJobSystem
+{
+public:
+	//Jobs a deque holds before run() executes inline
+	static const int DEQUE_SIZE = 1024;
+
+	//Initializes variables
+	LJobSystem();
+
+	//Stops the workers
+	~LJobSystem();
+
+	//Starts workers threads, the calling thread becomes the main thread
+	//Before start() every job runs inline at submission
+	bool start(int workers);
+
+	//Runs what is queued and joins the workers, held back jobs are dropped
+	void stop();
+
+	int getWorkerCount();
+
+	//Queues func(data), counting it on counter if not NULL
+	//With a dependency the job is held back until that counter reaches zero
+	void run(LJobFunc func, void* data, LJobCounter* counter = NULL, LJobCounter* dependency = NULL);
+
+	//Runs other jobs until counter reaches zero
+	void wait(LJobCounter* counter);
+
+	//Calls func(begin, end, data) over [0, count) in chunks of grain, spread over every thread, and waits
+	typedef void (*RangeFunc)(int begin, int end, void* data);
+	void parallelFor(int count, int grain, RangeFunc func, void* data);
+
+	//Queues func(data) for the main thread, for SDL calls that must stay there such as texture uploads
+	void runOnMainThread(LJobFunc func, void* data, LJobCounter* counter = NULL);
+
+	//Runs the main thread queue, called once per frame and while the main thread waits
+	void pumpMainThread();
+
+	//Stats of thread index, workers first and the main thread last
+	LJobStats getStats(int thread);
+	void resetStats();
+
+	//Prints busy time, jobs and steals of every thread since the last reset
+	void printStats();
+
+private:
+	//Bounded deque, the owner works at the bottom and thieves take from the top
+	struct Deque
+	{
+		SDL_SpinLock lock;
+		Uint32 top;
+		Uint32 bottom;
+		//Queued jobs, readable without the lock
+		SDL_atomic_t size;
+		LJob jobs[DEQUE_SIZE];
+		LJobStats stats;
+	};
+
+	struct Worker
+	{
+		LJobSystem* system;
+		int index;
+	};
+
+	struct Pending
+	{
+		LJob job;
+		LJobCounter* dependency;
+	};
+
+	static int SDLCALL workerThread(void* data);
+
+	//Pushes onto the caller's own deque, or a shared choice for outside threads
+	bool push(const LJob& job);
+
+	//Takes from the own deque, then steals from the others
+	bool next(int self, LJob& job, bool& stolen);
+
+	//Runs a job and retires it from its counter
+	void execute(int self, const LJob& job, bool stolen);
+	void finish(LJobCounter* counter);
+
+	//Index of the calling thread's deque, -1 outside the system
+	int self();
+
+	static thread_local int sThreadIndex;
+
+	std::vector<Deque*> mDeques;
+	std::vector<SDL_Thread*> mThreads;
+	std::vector<Worker> mWorkers;
+	SDL_atomic_t mQuit;
+	SDL_atomic_t mNextDeque;
+
+	//Sleeping workers wait here for new jobs
+	SDL_sem* mWake;
+	SDL_atomic_t mSleeping;
+
+	//Jobs waiting on a dependency
+	SDL_mutex* mPendingLock;
+	std::vector<Pending> mPending;
+	SDL_atomic_t mPendingCount;
+
+	//Jobs for the main thread
+	SDL_mutex* mMainLock;
+	std::vector<LJob> mMainJobs;
+	std::vector<LJob> mMainRunning;
+	SDL_atomic_t mMainCount;
+
+	Uint64 mStatsStart;
+};
+
+extern LJobSystem gJobSystem;
+#endif
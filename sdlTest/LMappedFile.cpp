@@ -0,0 +1,125 @@
+#include"LMappedFile.h"
+
+#include <stdio.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+LMappedFile::LMappedFile()
+{
+	//Initialize
+	mData = NULL;
+	mSize = 0;
+#if defined(_WIN32)
+	mFile = INVALID_HANDLE_VALUE;
+	mMapping = NULL;
+#else
+	mFile = -1;
+#endif
+}
+
+LMappedFile::~LMappedFile()
+{
+	//Deallocate
+	close();
+}
+
+bool LMappedFile::open(std::string path, bool copyOnWrite)
+{
+	close();
+
+#if defined(_WIN32)
+	//Writers may still open the file, LTiledImage::build() appends to the file it has mapped
+	mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(mFile, &fileSize) || fileSize.QuadPart == 0)
+	{
+		printf("Unable to map empty file %s\n", path.c_str());
+		close();
+		return false;
+	}
+	mSize = (size_t)fileSize.QuadPart;
+	mMapping = CreateFileMappingA(mFile, NULL, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+	mData = mMapping != NULL ? (Uint8*)MapViewOfFile(mMapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0) : NULL;
+#else
+	mFile = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (mFile < 0)
+	{
+		return false;
+	}
+	struct stat info;
+	if (fstat(mFile, &info) != 0 || info.st_size == 0)
+	{
+		printf("Unable to map empty file %s\n", path.c_str());
+		close();
+		return false;
+	}
+	mSize = (size_t)info.st_size;
+	void* data = mmap(NULL, mSize, copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, mFile, 0);
+	mData = data != MAP_FAILED ? (Uint8*)data : NULL;
+#endif
+	if (mData == NULL)
+	{
+		printf("Unable to map %s\n", path.c_str());
+		close();
+		return false;
+	}
+	return true;
+}
+
+void LMappedFile::close()
+{
+#if defined(_WIN32)
+	if (mData != NULL)
+	{
+		UnmapViewOfFile(mData);
+	}
+	if (mMapping != NULL)
+	{
+		CloseHandle(mMapping);
+		mMapping = NULL;
+	}
+	if (mFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFile);
+		mFile = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (mData != NULL)
+	{
+		munmap(mData, mSize);
+	}
+	if (mFile >= 0)
+	{
+		::close(mFile);
+		mFile = -1;
+	}
+#endif
+	mData = NULL;
+	mSize = 0;
+}
+
+bool LMappedFile::isOpen()
+{
+	return mData != NULL;
+}
+
+Uint8* LMappedFile::getData()
+{
+	return mData;
+}
+
+size_t LMappedFile::getSize()
+{
+	return mSize;
+}
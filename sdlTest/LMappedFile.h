@@ -0,0 +1,43 @@
+#pragma once
+
+#ifndef LMAPPEDFILE_H
+#define LMAPPEDFILE_H
+
+#include <string>
+#include "SDL.h"
+
+//Whole file mapped into memory, pages are read in on first touch
+class LMappedFile
+{
+public:
+	//Initializes variables
+	LMappedFile();
+
+	//Unmaps the file
+	~LMappedFile();
+
+	//Maps are owned by one object
+	LMappedFile(const LMappedFile&) = delete;
+	LMappedFile& operator=(const LMappedFile&) = delete;
+
+	//Maps path, false when it is missing or empty
+	//Copy on write mappings may be written, the file itself never changes
+	//Others may still open the file for writing and append to it, the mapping keeps its original size
+	bool open(std::string path, bool copyOnWrite = false);
+	void close();
+	bool isOpen();
+
+	Uint8* getData();
+	size_t getSize();
+
+private:
+	Uint8* mData;
+	size_t mSize;
+#if defined(_WIN32)
+	void* mFile;
+	void* mMapping;
+#else
+	int mFile;
+#endif
+};
+#endif
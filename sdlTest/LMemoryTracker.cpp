@@ -0,0 +1,197 @@
+#include"LMemoryTracker.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+//Never destroyed, so objects released by other globals at exit can still be untracked
+LMemoryTracker& gMemoryTracker = *new LMemoryTracker();
+
+static const char* CATEGORY_NAMES[LMemoryTracker::CATEGORY_COUNT] = { "textures", "surfaces", "fonts" };
+
+LMemoryTracker::LMemoryTracker()
+{
+	//Initialize
+	mLock = SDL_CreateMutex();
+	for (int i = 0; i < CATEGORY_COUNT; ++i)
+	{
+		mBytes[i] = 0;
+		mPeakBytes[i] = 0;
+		mCounts[i] = 0;
+	}
+}
+
+LMemoryTracker::~LMemoryTracker()
+{
+	//Deallocate
+	SDL_DestroyMutex(mLock);
+}
+
+void LMemoryTracker::track(const void* object, Category category, const char* path, int w, int h, Uint32 format, size_t bytes, const char* file, int line)
+{
+	if (object == NULL)
+	{
+		return;
+	}
+	Record record;
+	record.category = category;
+	record.path = path != NULL ? path : "";
+	record.w = w;
+	record.h = h;
+	record.format = format;
+	record.bytes = bytes;
+	record.file = file;
+	record.line = line;
+
+	SDL_LockMutex(mLock);
+
+	//Tracked again without an untrack, such as an address reused by an allocation nothing untracked
+	std::unordered_map<const void*, Record>::iterator found = mRecords.find(object);
+	if (found != mRecords.end())
+	{
+		mBytes[found->second.category] -= found->second.bytes;
+		--mCounts[found->second.category];
+		found->second = record;
+	}
+	else
+	{
+		mRecords[object] = record;
+	}
+	mBytes[category] += bytes;
+	++mCounts[category];
+	if (mBytes[category] > mPeakBytes[category])
+	{
+		mPeakBytes[category] = mBytes[category];
+	}
+	SDL_UnlockMutex(mLock);
+}
+
+void LMemoryTracker::untrack(const void* object)
+{
+	if (object == NULL)
+	{
+		return;
+	}
+	SDL_LockMutex(mLock);
+	std::unordered_map<const void*, Record>::iterator found = mRecords.find(object);
+	if (found != mRecords.end())
+	{
+		mBytes[found->second.category] -= found->second.bytes;
+		--mCounts[found->second.category];
+		mRecords.erase(found);
+	}
+	SDL_UnlockMutex(mLock);
+}
+
+void LMemoryTracker::printRecords(const char* title)
+{
+	//Largest first
+	std::vector<const Record*> sorted;
+	sorted.reserve(mRecords.size());
+	for (std::unordered_map<const void*, Record>::const_iterator it = mRecords.begin(); it != mRecords.end(); ++it)
+	{
+		sorted.push_back(&it->second);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const Record* a, const Record* b) { return a->bytes > b->bytes; });
+
+	printf("%s\n", title);
+	for (size_t i = 0; i < sorted.size(); ++i)
+	{
+		const Record& record = *sorted[i];
+		const char* format = record.format != 0 ? SDL_GetPixelFormatName(record.format) : "-";
+		printf("  %-8s %10u bytes %5dx%-5d %-24s %s (%s:%d)\n", CATEGORY_NAMES[record.category], (unsigned)record.bytes,
+			record.w, record.h, format, record.path.c_str(), record.file, record.line);
+	}
+}
+
+void LMemoryTracker::printReport()
+{
+	SDL_LockMutex(mLock);
+	printf("Asset memory:\n");
+	for (int i = 0; i < CATEGORY_COUNT; ++i)
+	{
+		printf("  %-8s %5u live, current %10u bytes, peak %10u bytes\n", CATEGORY_NAMES[i], mCounts[i],
+			(unsigned)mBytes[i], (unsigned)mPeakBytes[i]);
+	}
+	printRecords("Live objects:");
+	SDL_UnlockMutex(mLock);
+}
+
+bool LMemoryTracker::reportLeaks()
+{
+	SDL_LockMutex(mLock);
+	bool leaked = !mRecords.empty();
+	if (leaked)
+	{
+		printRecords("Leaked objects:");
+	}
+	SDL_UnlockMutex(mLock);
+	return leaked;
+}
+
+size_t LMemoryTracker::getBytes(Category category)
+{
+	SDL_LockMutex(mLock);
+	size_t bytes = mBytes[category];
+	SDL_UnlockMutex(mLock);
+	return bytes;
+}
+
+size_t LMemoryTracker::getPeakBytes(Category category)
+{
+	SDL_LockMutex(mLock);
+	size_t bytes = mPeakBytes[category];
+	SDL_UnlockMutex(mLock);
+	return bytes;
+}
+
+size_t LMemoryTracker::imageBytes(int w, int h, Uint32 format)
+{
+	//Planar YUV formats report zero bytes per pixel, they take 12 bits
+	int bytesPerPixel = SDL_BYTESPERPIXEL(format);
+	if (SDL_ISPIXELFORMAT_FOURCC(format))
+	{
+		return (size_t)w * h * 3 / 2;
+	}
+	return (size_t)w * h * bytesPerPixel;
+}
+
+void trackTexture(SDL_Texture* texture, const char* path, const char* file, int line)
+{
+	Uint32 format = 0;
+	int w = 0;
+	int h = 0;
+	if (texture == NULL || SDL_QueryTexture(texture, &format, NULL, &w, &h) != 0)
+	{
+		return;
+	}
+	gMemoryTracker.track(texture, LMemoryTracker::TEXTURE, path, w, h, format, LMemoryTracker::imageBytes(w, h, format), file, line);
+}
+
+void trackSurface(SDL_Surface* surface, const char* path, const char* file, int line)
+{
+	if (surface == NULL)
+	{
+		return;
+	}
+	gMemoryTracker.track(surface, LMemoryTracker::SURFACE, path, surface->w, surface->h, surface->format->format,
+		(size_t)surface->pitch * surface->h, file, line);
+}
+
+void SDLCALL destroyTrackedTexture(SDL_Texture* texture)
+{
+	LMEMORY_UNTRACK(texture);
+	SDL_DestroyTexture(texture);
+}
+
+void SDLCALL freeTrackedSurface(SDL_Surface* surface)
+{
+	LMEMORY_UNTRACK(surface);
+	SDL_FreeSurface(surface);
+}
+
+void SDLCALL closeTrackedFont(TTF_Font* font)
+{
+	LMEMORY_UNTRACK(font);
+	TTF_CloseFont(font);
+}
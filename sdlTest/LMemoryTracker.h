@@ -0,0 +1,97 @@
+#pragma once
+
+#ifndef LMEMORYTRACKER_H
+#define LMEMORYTRACKER_H
+
+#include <string>
+#include <unordered_map>
+#include "SDL.h"
+#include "SDL_ttf.h"
+
+//Build with LMEMORY_TRACKING=0 to compile all tracking out
+#ifndef LMEMORY_TRACKING
+#define LMEMORY_TRACKING 1
+#endif
+
+//Records every texture, surface and font created by the game so their memory can be reported
+class LMemoryTracker
+{
+public:
+	enum Category
+	{
+		TEXTURE,
+		SURFACE,
+		FONT,
+		CATEGORY_COUNT
+	};
+
+	//Initializes variables
+	LMemoryTracker();
+
+	//Deallocates the lock
+	~LMemoryTracker();
+
+	//Records a new object, creation site is filled in by the LMEMORY_TRACK macros
+	void track(const void* object, Category category, const char* path, int w, int h, Uint32 format, size_t bytes, const char* file, int line);
+
+	//Forgets a destroyed object, unknown objects are ignored
+	void untrack(const void* object);
+
+	//Prints current and peak totals per category and live objects sorted by size
+	void printReport();
+
+	//Prints live objects as leaks, returns true if there were any
+	bool reportLeaks();
+
+	//Current and peak bytes of one category
+	size_t getBytes(Category category);
+	size_t getPeakBytes(Category category);
+
+	//Bytes used by a w x h image in format
+	static size_t imageBytes(int w, int h, Uint32 format);
+
+private:
+	struct Record
+	{
+		Category category;
+		std::string path;
+		int w;
+		int h;
+		Uint32 format;
+		size_t bytes;
+		const char* file;
+		int line;
+	};
+
+	void printRecords(const char* title);
+
+	SDL_mutex* mLock;
+	std::unordered_map<const void*, Record> mRecords;
+	size_t mBytes[CATEGORY_COUNT];
+	size_t mPeakBytes[CATEGORY_COUNT];
+	Uint32 mCounts[CATEGORY_COUNT];
+};
+
+extern LMemoryTracker& gMemoryTracker;
+
+//Destroy functions that also untrack, used as deleters by the handle types
+void SDLCALL destroyTrackedTexture(SDL_Texture* texture);
+void SDLCALL freeTrackedSurface(SDL_Surface* surface);
+void SDLCALL closeTrackedFont(TTF_Font* font);
+
+#if LMEMORY_TRACKING
+//Records a texture, reading its size and format from SDL
+#define LMEMORY_TRACK_TEXTURE(texture, path) trackTexture((texture), (path), __FILE__, __LINE__)
+#define LMEMORY_TRACK_SURFACE(surface, path) trackSurface((surface), (path), __FILE__, __LINE__)
+#define LMEMORY_TRACK_FONT(font, path, bytes) gMemoryTracker.track((font), LMemoryTracker::FONT, (path), 0, 0, 0, (bytes), __FILE__, __LINE__)
+#define LMEMORY_UNTRACK(object) gMemoryTracker.untrack(object)
+#else
+#define LMEMORY_TRACK_TEXTURE(texture, path) ((void)0)
+#define LMEMORY_TRACK_SURFACE(surface, path) ((void)0)
+#define LMEMORY_TRACK_FONT(font, path, bytes) ((void)0)
+#define LMEMORY_UNTRACK(object) ((void)0)
+#endif
+
+void trackTexture(SDL_Texture* texture, const char* path, const char* file, int line);
+void trackSurface(SDL_Surface* surface, const char* path, const char* file, int line);
+#endif
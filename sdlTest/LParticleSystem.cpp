@@ -0,0 +1,261 @@
+#include"LParticleSystem.h"
+#include"LRenderStats.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PARTICLE_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLE_SSE 1
+#endif
+
+//Particles processed per SIMD step, storage is padded to a multiple of this
+static const int PARTICLE_LANES = 8;
+
+LParticleSystem::LParticleSystem()
+{
+	//Initialize
+	mCount = 0;
+	mCapacity = 0;
+	mPosX = NULL;
+	mPosY = NULL;
+	mVelX = NULL;
+	mVelY = NULL;
+	mLife = NULL;
+	mClip = NULL;
+	mTint = NULL;
+	mGravity = 200.0f;
+	mSeed = 0x9E3779B9u;
+	mTexture = NULL;
+	mSize = 8;
+	for (int i = 0; i < TINT_COUNT; ++i)
+	{
+		mTints[i].r = mTints[i].g = mTints[i].b = mTints[i].a = 0xFF;
+	}
+}
+
+LParticleSystem::~LParticleSystem()
+{
+	//Deallocate
+	free();
+}
+
+bool LParticleSystem::create(int capacity, SDL_Texture* texture, const SDL_Rect* clips, int clipCount, int size)
+{
+	//Get rid of preexisting particles
+	free();
+
+	int padded = (capacity + PARTICLE_LANES - 1) / PARTICLE_LANES * PARTICLE_LANES;
+	mPosX = (float*)SDL_SIMDAlloc(padded * sizeof(float));
+	mPosY = (float*)SDL_SIMDAlloc(padded * sizeof(float));
+	mVelX = (float*)SDL_SIMDAlloc(padded * sizeof(float));
+	mVelY = (float*)SDL_SIMDAlloc(padded * sizeof(float));
+	mLife = (float*)SDL_SIMDAlloc(padded * sizeof(float));
+	mClip = (Uint8*)SDL_SIMDAlloc(padded);
+	mTint = (Uint8*)SDL_SIMDAlloc(padded);
+	if (mPosX == NULL || mPosY == NULL || mVelX == NULL || mVelY == NULL || mLife == NULL || mClip == NULL || mTint == NULL)
+	{
+		printf("Unable to allocate %d particles!\n", capacity);
+		free();
+		return false;
+	}
+
+	//Padding lanes are integrated along with live particles, keep them finite
+	SDL_memset(mPosX, 0, padded * sizeof(float));
+	SDL_memset(mPosY, 0, padded * sizeof(float));
+	SDL_memset(mVelX, 0, padded * sizeof(float));
+	SDL_memset(mVelY, 0, padded * sizeof(float));
+	SDL_memset(mLife, 0, padded * sizeof(float));
+
+	mCapacity = capacity;
+	mTexture = texture;
+	mClips.assign(clips, clips + clipCount);
+	mSize = size;
+	mRects.resize(capacity);
+	mBatchStart.resize(clipCount * TINT_COUNT + 1);
+	return true;
+}
+
+void LParticleSystem::free()
+{
+	SDL_SIMDFree(mPosX);
+	SDL_SIMDFree(mPosY);
+	SDL_SIMDFree(mVelX);
+	SDL_SIMDFree(mVelY);
+	SDL_SIMDFree(mLife);
+	SDL_SIMDFree(mClip);
+	SDL_SIMDFree(mTint);
+	mPosX = mPosY = mVelX = mVelY = mLife = NULL;
+	mClip = mTint = NULL;
+	mCount = 0;
+	mCapacity = 0;
+	mClips.clear();
+	mRects.clear();
+	mBatchStart.clear();
+}
+
+int LParticleSystem::emit(float x, float y, int count, float speed, float life)
+{
+	if (count > mCapacity - mCount)
+	{
+		count = mCapacity - mCount;
+	}
+
+	for (int i = mCount; i < mCount + count; ++i)
+	{
+		//xorshift32, cheap enough to spawn hundreds of thousands per frame
+		mSeed ^= mSeed << 13;
+		mSeed ^= mSeed >> 17;
+		mSeed ^= mSeed << 5;
+		float angle = (mSeed & 0xFFFF) * (6.2831853f / 65536.0f);
+		float scale = ((mSeed >> 16) & 0xFF) * (1.0f / 255.0f);
+
+		mPosX[i] = x;
+		mPosY[i] = y;
+		mVelX[i] = SDL_cosf(angle) * speed * scale;
+		mVelY[i] = SDL_sinf(angle) * speed * scale - speed;
+		mLife[i] = life * (0.5f + 0.5f * scale);
+		mClip[i] = (Uint8)((mSeed >> 24) % mClips.size());
+		mTint[i] = (Uint8)((mSeed >> 8) % TINT_COUNT);
+	}
+	mCount += count;
+	return count;
+}
+
+void LParticleSystem::update(float dt)
+{
+	int padded = (mCount + PARTICLE_LANES - 1) / PARTICLE_LANES * PARTICLE_LANES;
+	float gravity = mGravity * dt;
+
+#if defined(PARTICLE_AVX)
+	__m256 vdt = _mm256_set1_ps(dt);
+	__m256 vgravity = _mm256_set1_ps(gravity);
+	for (int i = 0; i < padded; i += 8)
+	{
+		__m256 vx = _mm256_load_ps(mVelX + i);
+		__m256 vy = _mm256_add_ps(_mm256_load_ps(mVelY + i), vgravity);
+		_mm256_store_ps(mPosX + i, _mm256_add_ps(_mm256_load_ps(mPosX + i), _mm256_mul_ps(vx, vdt)));
+		_mm256_store_ps(mPosY + i, _mm256_add_ps(_mm256_load_ps(mPosY + i), _mm256_mul_ps(vy, vdt)));
+		_mm256_store_ps(mVelY + i, vy);
+		_mm256_store_ps(mLife + i, _mm256_sub_ps(_mm256_load_ps(mLife + i), vdt));
+	}
+#elif defined(PARTICLE_SSE)
+	__m128 vdt = _mm_set1_ps(dt);
+	__m128 vgravity = _mm_set1_ps(gravity);
+	for (int i = 0; i < padded; i += 4)
+	{
+		__m128 vx = _mm_load_ps(mVelX + i);
+		__m128 vy = _mm_add_ps(_mm_load_ps(mVelY + i), vgravity);
+		_mm_store_ps(mPosX + i, _mm_add_ps(_mm_load_ps(mPosX + i), _mm_mul_ps(vx, vdt)));
+		_mm_store_ps(mPosY + i, _mm_add_ps(_mm_load_ps(mPosY + i), _mm_mul_ps(vy, vdt)));
+		_mm_store_ps(mVelY + i, vy);
+		_mm_store_ps(mLife + i, _mm_sub_ps(_mm_load_ps(mLife + i), vdt));
+	}
+#else
+	for (int i = 0; i < padded; ++i)
+	{
+		mVelY[i] += gravity;
+		mPosX[i] += mVelX[i] * dt;
+		mPosY[i] += mVelY[i] * dt;
+		mLife[i] -= dt;
+	}
+#endif
+
+	compact();
+}
+
+void LParticleSystem::compact()
+{
+	//Every particle is copied to the write cursor, which only advances for survivors
+	int write = 0;
+	for (int i = 0; i < mCount; ++i)
+	{
+		mPosX[write] = mPosX[i];
+		mPosY[write] = mPosY[i];
+		mVelX[write] = mVelX[i];
+		mVelY[write] = mVelY[i];
+		mLife[write] = mLife[i];
+		mClip[write] = mClip[i];
+		mTint[write] = mTint[i];
+		write += (int)(mLife[i] > 0.0f);
+	}
+
+	//Reset the slots freed this frame so padding lanes stay finite
+	for (int i = write; i < mCount; ++i)
+	{
+		mVelX[i] = mVelY[i] = mLife[i] = 0.0f;
+	}
+	mCount = write;
+}
+
+void LParticleSystem::render(SDL_Renderer* ren)
+{
+	if (mTexture == NULL || mCount == 0)
+	{
+		return;
+	}
+
+	//Counting sort destination rects by batch so each batch is drawn contiguously
+	int batches = (int)mBatchStart.size() - 1;
+	SDL_memset(&mBatchStart[0], 0, mBatchStart.size() * sizeof(int));
+	for (int i = 0; i < mCount; ++i)
+	{
+		++mBatchStart[mClip[i] * TINT_COUNT + mTint[i] + 1];
+	}
+	for (int i = 0; i < batches; ++i)
+	{
+		mBatchStart[i + 1] += mBatchStart[i];
+	}
+
+	int half = mSize / 2;
+	for (int i = 0; i < mCount; ++i)
+	{
+		int batch = mClip[i] * TINT_COUNT + mTint[i];
+		SDL_Rect& rect = mRects[mBatchStart[batch]++];
+		rect.x = (int)mPosX[i] - half;
+		rect.y = (int)mPosY[i] - half;
+		rect.w = mSize;
+		rect.h = mSize;
+	}
+
+	//mBatchStart now holds each batch's end, which is the next batch's start
+	int start = 0;
+	for (int batch = 0; batch < batches; ++batch)
+	{
+		int end = mBatchStart[batch];
+		if (end > start)
+		{
+			const SDL_Color& tint = mTints[batch % TINT_COUNT];
+			const SDL_Rect& clip = mClips[batch / TINT_COUNT];
+			renderSetTextureColorMod(mTexture, tint.r, tint.g, tint.b);
+			for (int i = start; i < end; ++i)
+			{
+				renderCopy(ren, mTexture, &clip, &mRects[i]);
+			}
+		}
+		start = end;
+	}
+	renderSetTextureColorMod(mTexture, 0xFF, 0xFF, 0xFF);
+}
+
+void LParticleSystem::setTint(int tint, Uint8 red, Uint8 green, Uint8 blue)
+{
+	mTints[tint].r = red;
+	mTints[tint].g = green;
+	mTints[tint].b = blue;
+}
+
+void LParticleSystem::setGravity(float gravity)
+{
+	mGravity = gravity;
+}
+
+int LParticleSystem::getCount()
+{
+	return mCount;
+}
+
+int LParticleSystem::getCapacity()
+{
+	return mCapacity;
+}
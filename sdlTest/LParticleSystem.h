@@ -0,0 +1,78 @@
+#pragma once
+
+#ifndef LPARTICLESYSTEM_H
+#define LPARTICLESYSTEM_H
+
+#include <stdio.h>
+#include <vector>
+#include "SDL.h"
+
+//CPU particle engine storing particles as structure of arrays
+//Updated with SSE or AVX kernels and rendered in batches per sprite clip and tint
+class LParticleSystem
+{
+public:
+	//Number of color tints particles are spread over
+	static const int TINT_COUNT = 4;
+
+	//Initializes variables
+	LParticleSystem();
+
+	//Deallocates memory
+	~LParticleSystem();
+
+	//Allocates storage for up to capacity particles drawn from clips of texture
+	bool create(int capacity, SDL_Texture* texture, const SDL_Rect* clips, int clipCount, int size = 8);
+
+	//Deallocates particle storage
+	void free();
+
+	//Spawns up to count particles at the given point, returns how many were spawned
+	int emit(float x, float y, int count, float speed = 120.0f, float life = 2.0f);
+
+	//Integrates motion and lifetime then compacts dead particles away
+	void update(float dt);
+
+	//Draws every live particle, one color modulation per clip and tint batch
+	void render(SDL_Renderer* ren);
+
+	//Sets the color used for a tint batch
+	void setTint(int tint, Uint8 red, Uint8 green, Uint8 blue);
+
+	//Sets the downward acceleration
+	void setGravity(float gravity);
+
+	int getCount();
+	int getCapacity();
+
+private:
+	//Removes particles whose lifetime ran out without branching per particle
+	void compact();
+
+	//Live particle count and allocated slots
+	int mCount;
+	int mCapacity;
+
+	//Particle attributes, aligned for SIMD
+	float* mPosX;
+	float* mPosY;
+	float* mVelX;
+	float* mVelY;
+	float* mLife;
+	Uint8* mClip;
+	Uint8* mTint;
+
+	float mGravity;
+	Uint32 mSeed;
+
+	//Sprite source
+	SDL_Texture* mTexture;
+	std::vector<SDL_Rect> mClips;
+	int mSize;
+	SDL_Color mTints[TINT_COUNT];
+
+	//Destination rects bucketed by batch, reused every frame
+	std::vector<SDL_Rect> mRects;
+	std::vector<int> mBatchStart;
+};
+#endif
@@ -0,0 +1,114 @@
+#include"LProfiler.h"
+
+#include <stdio.h>
+
+LProfiler gProfiler;
+
+thread_local LProfiler::ThreadRing* LProfiler::sThreadRing = NULL;
+
+LProfiler::LProfiler()
+{
+	//Initialize
+	mLock = SDL_CreateMutex();
+	mCaptureFrames = 0;
+	mCaptureStart = 0;
+}
+
+LProfiler::~LProfiler()
+{
+	//Deallocate
+	for (size_t i = 0; i < mThreads.size(); ++i)
+	{
+		delete mThreads[i];
+	}
+	SDL_DestroyMutex(mLock);
+}
+
+LProfiler::ThreadRing* LProfiler::registerThread()
+{
+	//First zone on this thread, rings live until the profiler goes away
+	ThreadRing* ring = new ThreadRing();
+	ring->events.resize(RING_SIZE);
+	ring->written = 0;
+	SDL_AtomicSet(&ring->next, 0);
+	ring->id = SDL_ThreadID();
+
+	SDL_LockMutex(mLock);
+	mThreads.push_back(ring);
+	SDL_UnlockMutex(mLock);
+
+	sThreadRing = ring;
+	return ring;
+}
+
+void LProfiler::captureFrames(std::string path, int frames)
+{
+	mCapturePath = path;
+	mCaptureFrames = frames;
+	mCaptureStart = SDL_GetPerformanceCounter();
+}
+
+bool LProfiler::isCapturing()
+{
+	return mCaptureFrames > 0;
+}
+
+void LProfiler::frameMark()
+{
+	if (mCaptureFrames <= 0 || --mCaptureFrames > 0)
+	{
+		return;
+	}
+	if (exportTrace(mCapturePath, mCaptureStart, SDL_GetPerformanceCounter()))
+	{
+		printf("Profiler trace written to %s\n", mCapturePath.c_str());
+	}
+}
+
+bool LProfiler::exportTrace(const std::string& path, Uint64 start, Uint64 end)
+{
+	SDL_RWops* file = SDL_RWFromFile(path.c_str(), "wb");
+	if (file == NULL)
+	{
+		printf("Unable to open trace file %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+		return false;
+	}
+
+	double toMicroseconds = 1e6 / (double)SDL_GetPerformanceFrequency();
+	const char header[] = "{\"traceEvents\":[\n";
+	SDL_RWwrite(file, header, 1, sizeof(header) - 1);
+
+	bool first = true;
+	char line[256];
+	SDL_LockMutex(mLock);
+	for (size_t t = 0; t < mThreads.size(); ++t)
+	{
+		ThreadRing* ring = mThreads[t];
+		Uint32 next = (Uint32)SDL_AtomicGet(&ring->next);
+		Uint32 count = next < (Uint32)RING_SIZE ? next : (Uint32)RING_SIZE;
+		for (Uint32 i = next - count; i != next; ++i)
+		{
+			//The owner keeps recording, a slot it has started overwriting since the copy is dropped
+			LProfileEvent event = ring->events[i & (RING_SIZE - 1)];
+			if ((Uint32)SDL_AtomicGet(&ring->next) - i >= (Uint32)RING_SIZE)
+			{
+				continue;
+			}
+			if (event.start < start || event.start > end)
+			{
+				continue;
+			}
+			int len = SDL_snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+				first ? "" : ",\n", event.name, (unsigned long)ring->id,
+				(event.start - start) * toMicroseconds, (event.end - event.start) * toMicroseconds);
+			SDL_RWwrite(file, line, 1, len);
+			first = false;
+		}
+	}
+	SDL_UnlockMutex(mLock);
+
+	const char footer[] = "\n]}\n";
+	SDL_RWwrite(file, footer, 1, sizeof(footer) - 1);
+	SDL_RWclose(file);
+	return true;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#ifndef LPROFILER_H
+#define LPROFILER_H
+
+#include <iostream>
+#include <vector>
+#include "SDL.h"
+
+//Build with LPROFILER_ENABLED=0 to compile every zone out
+#ifndef LPROFILER_ENABLED
+#define LPROFILER_ENABLED 1
+#endif
+
+//One timed zone
+struct LProfileEvent
+{
+	const char* name;
+	Uint64 start;
+	Uint64 end;
+};
+
+//Collects zones from every thread into per thread rings and exports frame ranges as Chrome trace JSON
+class LProfiler
+{
+public:
+	//Events kept per thread before the oldest are overwritten
+	static const int RING_SIZE = 1 << 16;
+
+	//Initializes variables
+	LProfiler();
+
+	//Deallocates thread rings
+	~LProfiler();
+
+	//Records a finished zone on the calling thread, name must outlive the profiler
+	void record(const char* name, Uint64 start, Uint64 end)
+	{
+		ThreadRing* ring = sThreadRing != NULL ? sThreadRing : registerThread();
+		LProfileEvent& event = ring->events[ring->written & (RING_SIZE - 1)];
+		event.name = name;
+		event.start = start;
+		event.end = end;
+
+		//Published only once the event is whole, exportTrace() reads from other threads
+		SDL_AtomicSet(&ring->next, (int)++ring->written);
+	}
+
+	//Marks the end of a frame, finishes a capture once enough frames were seen
+	void frameMark();
+
+	//Captures the next frames and writes them to path as about:tracing JSON
+	void captureFrames(std::string path, int frames);
+
+	bool isCapturing();
+
+private:
+	struct ThreadRing
+	{
+		std::vector<LProfileEvent> events;
+		//Events written, only touched by the owning thread
+		Uint32 written;
+		//Events published to exportTrace()
+		SDL_atomic_t next;
+		SDL_threadID id;
+	};
+
+	ThreadRing* registerThread();
+
+	//Writes every zone that started inside [start, end]
+	bool exportTrace(const std::string& path, Uint64 start, Uint64 end);
+
+	static thread_local ThreadRing* sThreadRing;
+
+	SDL_mutex* mLock;
+	std::vector<ThreadRing*> mThreads;
+
+	//Capture in progress
+	std::string mCapturePath;
+	int mCaptureFrames;
+	Uint64 mCaptureStart;
+};
+
+extern LProfiler gProfiler;
+
+//Times its own scope
+class LProfileZone
+{
+public:
+	explicit LProfileZone(const char* name) : mName(name), mStart(SDL_GetPerformanceCounter()) {}
+	~LProfileZone() { gProfiler.record(mName, mStart, SDL_GetPerformanceCounter()); }
+
+private:
+	const char* mName;
+	Uint64 mStart;
+};
+
+#if LPROFILER_ENABLED
+#define LPROFILE_CONCAT_INNER(a, b) a##b
+#define LPROFILE_CONCAT(a, b) LPROFILE_CONCAT_INNER(a, b)
+//Times the rest of the enclosing scope under name
+#define LPROFILE_ZONE(name) LProfileZone LPROFILE_CONCAT(profileZone, __LINE__)(name)
+#define LPROFILE_FRAME() gProfiler.frameMark()
+#else
+#define LPROFILE_ZONE(name) ((void)0)
+#define LPROFILE_FRAME() ((void)0)
+#endif
+#endif
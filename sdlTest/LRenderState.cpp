@@ -0,0 +1,156 @@
+#include"LRenderState.h"
+#include"LRenderStats.h"
+
+LRenderState::LRenderState()
+{
+	//Initialize
+	mRenderer = NULL;
+	mIssued = 0;
+	mElided = 0;
+	mLastIssued = 0;
+	mLastElided = 0;
+	invalidate();
+}
+
+void LRenderState::attach(SDL_Renderer* ren)
+{
+	mRenderer = ren;
+	invalidate();
+}
+
+void LRenderState::invalidate()
+{
+	mHasDrawColor = false;
+	mHasBlendMode = false;
+	mHasViewport = false;
+	mHasClipRect = false;
+}
+
+bool LRenderState::issue(bool changed)
+{
+	if (changed)
+	{
+		++mIssued;
+	}
+	else
+	{
+		++mElided;
+	}
+	return changed;
+}
+
+bool LRenderState::sameRect(const SDL_Rect* a, bool aSet, const SDL_Rect* b)
+{
+	//A NULL rect means the whole target
+	if (!aSet || b == NULL)
+	{
+		return !aSet && b == NULL;
+	}
+	return a->x == b->x && a->y == b->y && a->w == b->w && a->h == b->h;
+}
+
+void LRenderState::setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+	bool changed = !mHasDrawColor || mDrawColor.r != r || mDrawColor.g != g || mDrawColor.b != b || mDrawColor.a != a;
+	if (issue(changed))
+	{
+		renderSetDrawColor(mRenderer, r, g, b, a);
+		mDrawColor.r = r;
+		mDrawColor.g = g;
+		mDrawColor.b = b;
+		mDrawColor.a = a;
+		mHasDrawColor = true;
+	}
+}
+
+void LRenderState::setDrawBlendMode(SDL_BlendMode mode)
+{
+	if (issue(!mHasBlendMode || mBlendMode != mode))
+	{
+		renderSetDrawBlendMode(mRenderer, mode);
+		mBlendMode = mode;
+		mHasBlendMode = true;
+	}
+}
+
+void LRenderState::setViewport(const SDL_Rect* rect)
+{
+	if (issue(!mHasViewport || !sameRect(&mViewport, mViewportSet, rect)))
+	{
+		renderSetViewport(mRenderer, rect);
+		mViewportSet = rect != NULL;
+		if (rect != NULL)
+		{
+			mViewport = *rect;
+		}
+		mHasViewport = true;
+	}
+}
+
+void LRenderState::setClipRect(const SDL_Rect* rect)
+{
+	if (issue(!mHasClipRect || !sameRect(&mClipRect, mClipRectSet, rect)))
+	{
+		renderSetClipRect(mRenderer, rect);
+		mClipRectSet = rect != NULL;
+		if (rect != NULL)
+		{
+			mClipRect = *rect;
+		}
+		mHasClipRect = true;
+	}
+}
+
+void LRenderState::setTextureColorMod(SDL_Texture* texture, Uint8 r, Uint8 g, Uint8 b)
+{
+	//The texture keeps its own modulation, which is always current even if the pointer was reused
+	Uint8 oldR = 0, oldG = 0, oldB = 0;
+	bool known = SDL_GetTextureColorMod(texture, &oldR, &oldG, &oldB) == 0;
+	if (issue(!known || oldR != r || oldG != g || oldB != b))
+	{
+		renderSetTextureColorMod(texture, r, g, b);
+	}
+}
+
+void LRenderState::setTextureAlphaMod(SDL_Texture* texture, Uint8 alpha)
+{
+	Uint8 oldAlpha = 0;
+	bool known = SDL_GetTextureAlphaMod(texture, &oldAlpha) == 0;
+	if (issue(!known || oldAlpha != alpha))
+	{
+		renderSetTextureAlphaMod(texture, alpha);
+	}
+}
+
+void LRenderState::setTextureBlendMode(SDL_Texture* texture, SDL_BlendMode mode)
+{
+	SDL_BlendMode oldMode = SDL_BLENDMODE_INVALID;
+	bool known = SDL_GetTextureBlendMode(texture, &oldMode) == 0;
+	if (issue(!known || oldMode != mode))
+	{
+		renderSetTextureBlendMode(texture, mode);
+	}
+}
+
+void LRenderState::endFrame()
+{
+	mLastIssued = mIssued;
+	mLastElided = mElided;
+	mIssued = 0;
+	mElided = 0;
+}
+
+Uint32 LRenderState::getIssuedCalls()
+{
+	return mLastIssued;
+}
+
+Uint32 LRenderState::getElidedCalls()
+{
+	return mLastElided;
+}
+
+SDL_Renderer* LRenderState::getRenderer()
+{
+	return mRenderer;
+}
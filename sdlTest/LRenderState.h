@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef LRENDERSTATE_H
+#define LRENDERSTATE_H
+
+#include "SDL.h"
+
+//Shadows renderer state and drops SDL calls that would not change it
+class LRenderState
+{
+public:
+	//Initializes variables
+	LRenderState();
+
+	//Starts tracking a renderer, its current state is unknown until first set
+	void attach(SDL_Renderer* ren);
+
+	//Forgets shadowed state, call after changing state directly or switching render targets
+	void invalidate();
+
+	//Renderer state
+	void setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+	void setDrawBlendMode(SDL_BlendMode mode);
+	void setViewport(const SDL_Rect* rect);
+	void setClipRect(const SDL_Rect* rect);
+
+	//Texture state, compared against the values the texture already holds
+	void setTextureColorMod(SDL_Texture* texture, Uint8 r, Uint8 g, Uint8 b);
+	void setTextureAlphaMod(SDL_Texture* texture, Uint8 alpha);
+	void setTextureBlendMode(SDL_Texture* texture, SDL_BlendMode mode);
+
+	//Ends a frame, making its counters available through the getters below
+	void endFrame();
+
+	//Calls forwarded to SDL and calls dropped during the last frame
+	Uint32 getIssuedCalls();
+	Uint32 getElidedCalls();
+
+	SDL_Renderer* getRenderer();
+
+private:
+	//Counts a call and reports whether it has to be issued
+	bool issue(bool changed);
+
+	static bool sameRect(const SDL_Rect* a, bool aSet, const SDL_Rect* b);
+
+	SDL_Renderer* mRenderer;
+
+	//Shadowed renderer state, only meaningful while the matching flag is set
+	bool mHasDrawColor;
+	SDL_Color mDrawColor;
+	bool mHasBlendMode;
+	SDL_BlendMode mBlendMode;
+	bool mHasViewport;
+	bool mViewportSet;
+	SDL_Rect mViewport;
+	bool mHasClipRect;
+	bool mClipRectSet;
+	SDL_Rect mClipRect;
+
+	//Counters for the frame in progress and the last finished frame
+	Uint32 mIssued;
+	Uint32 mElided;
+	Uint32 mLastIssued;
+	Uint32 mLastElided;
+};
+#endif
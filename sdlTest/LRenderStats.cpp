@@ -0,0 +1,183 @@
+#include"LRenderStats.h"
+
+#include <stdio.h>
+
+LRenderStats gRenderStats;
+
+static const char* sCallNames[LRenderStats::CALL_COUNT] =
+{
+	"RenderCopy",
+	"RenderFillRect",
+	"RenderDrawRect",
+	"RenderDrawLine",
+	"RenderDrawPoint",
+	"RenderDrawPoints",
+	"RenderClear",
+	"SetRenderDrawColor",
+	"SetRenderDrawBlendMode",
+	"RenderSetViewport",
+	"RenderSetClipRect",
+	"SetTextureColorMod",
+	"SetTextureAlphaMod",
+	"SetTextureBlendMode",
+	"UpdateTexture"
+};
+
+LRenderStats::LRenderStats()
+{
+	//Initialize
+	mEnabled = false;
+	mLastTexture = NULL;
+	SDL_zero(mFrame);
+	SDL_zero(mLastFrame);
+	mCsv = NULL;
+	mFrameNumber = 0;
+}
+
+LRenderStats::~LRenderStats()
+{
+	//Deallocate
+	stopCsv();
+}
+
+bool LRenderStats::startCsv(std::string path)
+{
+	stopCsv();
+	mCsv = SDL_RWFromFile(path.c_str(), "wb");
+	if (mCsv == NULL)
+	{
+		printf("Unable to open render stats file %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+		return false;
+	}
+
+	char line[512];
+	int len = SDL_snprintf(line, sizeof(line), "frame,draw_calls,texture_switches,src_pixels,dst_pixels,upload_bytes");
+	for (int i = 0; i < CALL_COUNT; ++i)
+	{
+		len += SDL_snprintf(line + len, sizeof(line) - len, ",%s", sCallNames[i]);
+	}
+	len += SDL_snprintf(line + len, sizeof(line) - len, "\n");
+	SDL_RWwrite(mCsv, line, 1, len);
+	mFrameNumber = 0;
+	return true;
+}
+
+void LRenderStats::stopCsv()
+{
+	if (mCsv != NULL)
+	{
+		SDL_RWclose(mCsv);
+		mCsv = NULL;
+	}
+}
+
+bool LRenderStats::isLogging()
+{
+	return mCsv != NULL;
+}
+
+void LRenderStats::countCopy(SDL_Renderer* ren, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst)
+{
+	++mFrame.calls[COPY];
+	++mFrame.drawCalls;
+	if (texture != mLastTexture)
+	{
+		++mFrame.textureSwitches;
+		mLastTexture = texture;
+	}
+
+	//NULL rects mean the whole texture and the whole viewport
+	if (src != NULL)
+	{
+		mFrame.srcPixels += (Uint64)src->w * src->h;
+	}
+	else
+	{
+		int w = 0;
+		int h = 0;
+		SDL_QueryTexture(texture, NULL, NULL, &w, &h);
+		mFrame.srcPixels += (Uint64)w * h;
+	}
+	if (dst != NULL)
+	{
+		mFrame.dstPixels += (Uint64)dst->w * dst->h;
+	}
+	else
+	{
+		SDL_Rect viewport;
+		SDL_RenderGetViewport(ren, &viewport);
+		mFrame.dstPixels += (Uint64)viewport.w * viewport.h;
+	}
+}
+
+void LRenderStats::countFill(SDL_Renderer* ren, Call call, const SDL_Rect* rect)
+{
+	++mFrame.calls[call];
+	++mFrame.drawCalls;
+	if (rect != NULL)
+	{
+		mFrame.dstPixels += (Uint64)rect->w * rect->h;
+	}
+	else
+	{
+		SDL_Rect viewport;
+		SDL_RenderGetViewport(ren, &viewport);
+		mFrame.dstPixels += (Uint64)viewport.w * viewport.h;
+	}
+}
+
+void LRenderStats::countUpload(SDL_Texture* texture, const SDL_Rect* rect, int pitch)
+{
+	++mFrame.calls[UPDATE_TEXTURE];
+	int h = 0;
+	if (rect != NULL)
+	{
+		h = rect->h;
+	}
+	else
+	{
+		SDL_QueryTexture(texture, NULL, NULL, NULL, &h);
+	}
+	mFrame.uploadBytes += (Uint64)pitch * h;
+}
+
+void LRenderStats::endFrame()
+{
+	if (mCsv != NULL)
+	{
+		char line[512];
+		int len = SDL_snprintf(line, sizeof(line), "%u,%u,%u,%llu,%llu,%llu", mFrameNumber, mFrame.drawCalls, mFrame.textureSwitches,
+			(unsigned long long)mFrame.srcPixels, (unsigned long long)mFrame.dstPixels, (unsigned long long)mFrame.uploadBytes);
+		for (int i = 0; i < CALL_COUNT; ++i)
+		{
+			len += SDL_snprintf(line + len, sizeof(line) - len, ",%u", mFrame.calls[i]);
+		}
+		len += SDL_snprintf(line + len, sizeof(line) - len, "\n");
+		SDL_RWwrite(mCsv, line, 1, len);
+		++mFrameNumber;
+	}
+
+	mLastFrame = mFrame;
+	SDL_zero(mFrame);
+	mLastTexture = NULL;
+}
+
+Uint32 LRenderStats::getDrawCalls()
+{
+	return mLastFrame.drawCalls;
+}
+
+Uint32 LRenderStats::getTextureSwitches()
+{
+	return mLastFrame.textureSwitches;
+}
+
+const LRenderStats::Frame& LRenderStats::getLastFrame()
+{
+	return mLastFrame;
+}
+
+const char* LRenderStats::getCallName(Call call)
+{
+	return sCallNames[call];
+}
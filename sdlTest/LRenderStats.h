@@ -0,0 +1,244 @@
+#pragma once
+
+#ifndef LRENDERSTATS_H
+#define LRENDERSTATS_H
+
+#include <iostream>
+#include "SDL.h"
+
+//Counts the SDL render calls issued per frame, with the pixel areas they touch
+//Everything goes through the render* wrappers below, which cost one branch while disabled
+class LRenderStats
+{
+public:
+	//Intercepted calls, also the CSV column order
+	enum Call
+	{
+		COPY,
+		FILL_RECT,
+		DRAW_RECT,
+		DRAW_LINE,
+		DRAW_POINT,
+		DRAW_POINTS,
+		CLEAR,
+		SET_DRAW_COLOR,
+		SET_DRAW_BLEND_MODE,
+		SET_VIEWPORT,
+		SET_CLIP_RECT,
+		SET_TEXTURE_COLOR_MOD,
+		SET_TEXTURE_ALPHA_MOD,
+		SET_TEXTURE_BLEND_MODE,
+		UPDATE_TEXTURE,
+		CALL_COUNT
+	};
+
+	//Totals for one frame
+	struct Frame
+	{
+		Uint32 calls[CALL_COUNT];
+		Uint32 drawCalls;
+		Uint32 textureSwitches;
+		//Source texels read and destination pixels covered by copies and fills
+		Uint64 srcPixels;
+		Uint64 dstPixels;
+		//Bytes handed to SDL_UpdateTexture
+		Uint64 uploadBytes;
+	};
+
+	//Initializes variables
+	LRenderStats();
+
+	//Deallocates CSV output
+	~LRenderStats();
+
+	//Turns counting on or off, off is the default
+	void setEnabled(bool enabled)
+	{
+		mEnabled = enabled;
+	}
+	bool isEnabled() const
+	{
+		return mEnabled;
+	}
+
+	//Appends one row per frame to a CSV file until stopped, counting must be enabled separately
+	bool startCsv(std::string path);
+	void stopCsv();
+	bool isLogging();
+
+	//Recording, called by the wrappers only while enabled
+	void countCopy(SDL_Renderer* ren, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst);
+	void countFill(SDL_Renderer* ren, Call call, const SDL_Rect* rect);
+	void countUpload(SDL_Texture* texture, const SDL_Rect* rect, int pitch);
+	void countDraw(Call call, int points)
+	{
+		++mFrame.calls[call];
+		++mFrame.drawCalls;
+		mFrame.dstPixels += points;
+	}
+	void countState(Call call)
+	{
+		++mFrame.calls[call];
+	}
+
+	//Ends a frame, writing its CSV row and making its counters available through the getters below
+	void endFrame();
+
+	//Counters of the last finished frame
+	Uint32 getDrawCalls();
+	Uint32 getTextureSwitches();
+	const Frame& getLastFrame();
+
+	//Column name of a call
+	static const char* getCallName(Call call);
+
+private:
+	bool mEnabled;
+
+	SDL_Texture* mLastTexture;
+	Frame mFrame;
+	Frame mLastFrame;
+
+	//CSV output, NULL when not logging
+	SDL_RWops* mCsv;
+	Uint32 mFrameNumber;
+};
+
+extern LRenderStats gRenderStats;
+
+//Counted versions of the SDL render calls
+inline int renderCopy(SDL_Renderer* ren, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countCopy(ren, texture, src, dst);
+	}
+	return SDL_RenderCopy(ren, texture, src, dst);
+}
+
+inline int renderFillRect(SDL_Renderer* ren, const SDL_Rect* rect)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countFill(ren, LRenderStats::FILL_RECT, rect);
+	}
+	return SDL_RenderFillRect(ren, rect);
+}
+
+inline int renderDrawRect(SDL_Renderer* ren, const SDL_Rect* rect)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countDraw(LRenderStats::DRAW_RECT, 0);
+	}
+	return SDL_RenderDrawRect(ren, rect);
+}
+
+inline int renderDrawLine(SDL_Renderer* ren, int x1, int y1, int x2, int y2)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countDraw(LRenderStats::DRAW_LINE, 0);
+	}
+	return SDL_RenderDrawLine(ren, x1, y1, x2, y2);
+}
+
+inline int renderDrawPoint(SDL_Renderer* ren, int x, int y)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countDraw(LRenderStats::DRAW_POINT, 1);
+	}
+	return SDL_RenderDrawPoint(ren, x, y);
+}
+
+inline int renderDrawPoints(SDL_Renderer* ren, const SDL_Point* points, int count)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countDraw(LRenderStats::DRAW_POINTS, count);
+	}
+	return SDL_RenderDrawPoints(ren, points, count);
+}
+
+inline int renderClear(SDL_Renderer* ren)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countFill(ren, LRenderStats::CLEAR, NULL);
+	}
+	return SDL_RenderClear(ren);
+}
+
+inline int renderSetDrawColor(SDL_Renderer* ren, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countState(LRenderStats::SET_DRAW_COLOR);
+	}
+	return SDL_SetRenderDrawColor(ren, r, g, b, a);
+}
+
+inline int renderSetDrawBlendMode(SDL_Renderer* ren, SDL_BlendMode mode)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countState(LRenderStats::SET_DRAW_BLEND_MODE);
+	}
+	return SDL_SetRenderDrawBlendMode(ren, mode);
+}
+
+inline int renderSetViewport(SDL_Renderer* ren, const SDL_Rect* rect)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countState(LRenderStats::SET_VIEWPORT);
+	}
+	return SDL_RenderSetViewport(ren, rect);
+}
+
+inline int renderSetClipRect(SDL_Renderer* ren, const SDL_Rect* rect)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countState(LRenderStats::SET_CLIP_RECT);
+	}
+	return SDL_RenderSetClipRect(ren, rect);
+}
+
+inline int renderSetTextureColorMod(SDL_Texture* texture, Uint8 r, Uint8 g, Uint8 b)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countState(LRenderStats::SET_TEXTURE_COLOR_MOD);
+	}
+	return SDL_SetTextureColorMod(texture, r, g, b);
+}
+
+inline int renderSetTextureAlphaMod(SDL_Texture* texture, Uint8 alpha)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countState(LRenderStats::SET_TEXTURE_ALPHA_MOD);
+	}
+	return SDL_SetTextureAlphaMod(texture, alpha);
+}
+
+inline int renderSetTextureBlendMode(SDL_Texture* texture, SDL_BlendMode mode)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countState(LRenderStats::SET_TEXTURE_BLEND_MODE);
+	}
+	return SDL_SetTextureBlendMode(texture, mode);
+}
+
+inline int renderUpdateTexture(SDL_Texture* texture, const SDL_Rect* rect, const void* pixels, int pitch)
+{
+	if (gRenderStats.isEnabled())
+	{
+		gRenderStats.countUpload(texture, rect, pitch);
+	}
+	return SDL_UpdateTexture(texture, rect, pixels, pitch);
+}
+#endif
@@ -0,0 +1,276 @@
+#include"LRenderThread.h"
+#include"LRenderStats.h"
+#include"LProfiler.h"
+
+#include <stdio.h>
+
+LRenderThread gRenderThread;
+
+//Commands reserved per frame so steady state recording does not allocate
+static const size_t FRAME_COMMANDS = 4096;
+
+LLatencyStats::LLatencyStats()
+{
+	//Initialize
+	mLock = 0;
+	reset();
+}
+
+void LLatencyStats::record(Uint64 inputTime, Uint64 presentTime)
+{
+	SDL_AtomicLock(&mLock);
+	if (mFrames == 0)
+	{
+		mFirstPresent = presentTime;
+	}
+	++mFrames;
+	mLastPresent = presentTime;
+	if (inputTime != 0)
+	{
+		Uint64 latency = presentTime - inputTime;
+		++mInputs;
+		mLatencyTicks += latency;
+		mMaxLatencyTicks = SDL_max(mMaxLatencyTicks, latency);
+	}
+	SDL_AtomicUnlock(&mLock);
+}
+
+void LLatencyStats::print(const char* label)
+{
+	SDL_AtomicLock(&mLock);
+	double toMilliseconds = 1000.0 / SDL_GetPerformanceFrequency();
+	double seconds = (mLastPresent - mFirstPresent) * toMilliseconds / 1000.0;
+	printf("%s: %u frames, %.1f fps, input to present avg %.2f ms, max %.2f ms over %u inputs\n", label, mFrames,
+		seconds > 0.0 ? (mFrames - 1) / seconds : 0.0, mInputs > 0 ? mLatencyTicks * toMilliseconds / mInputs : 0.0,
+		mMaxLatencyTicks * toMilliseconds, mInputs);
+	SDL_AtomicUnlock(&mLock);
+}
+
+void LLatencyStats::reset()
+{
+	SDL_AtomicLock(&mLock);
+	mFrames = 0;
+	mInputs = 0;
+	mLatencyTicks = 0;
+	mMaxLatencyTicks = 0;
+	mFirstPresent = 0;
+	mLastPresent = 0;
+	SDL_AtomicUnlock(&mLock);
+}
+
+LFrameRing::LFrameRing()
+{
+	//Initialize
+	SDL_zero(mSlots);
+	SDL_AtomicSet(&mHead, 0);
+	SDL_AtomicSet(&mTail, 0);
+}
+
+bool LFrameRing::push(int slot)
+{
+	//Only the producer moves the tail
+	int tail = SDL_AtomicGet(&mTail);
+	if (tail - SDL_AtomicGet(&mHead) >= SIZE)
+	{
+		return false;
+	}
+	mSlots[tail & (SIZE - 1)] = slot;
+	SDL_AtomicSet(&mTail, tail + 1);
+	return true;
+}
+
+bool LFrameRing::pop(int& slot)
+{
+	//Only the consumer moves the head
+	int head = SDL_AtomicGet(&mHead);
+	if (head == SDL_AtomicGet(&mTail))
+	{
+		return false;
+	}
+	slot = mSlots[head & (SIZE - 1)];
+	SDL_AtomicSet(&mHead, head + 1);
+	return true;
+}
+
+LRenderThread::LRenderThread()
+{
+	//Initialize
+	mRecording = -1;
+	mReadyCount = SDL_CreateSemaphore(0);
+	mFreeCount = SDL_CreateSemaphore(0);
+	mThread = NULL;
+	mRenderer = NULL;
+	SDL_AtomicSet(&mQuit, 0);
+	mWindow = NULL;
+	mContext = NULL;
+	for (int i = 0; i < FRAME_COUNT; ++i)
+	{
+		mFrames[i].inputTime = 0;
+	}
+}
+
+LRenderThread::~LRenderThread()
+{
+	//Deallocate
+	stop();
+	SDL_DestroySemaphore(mFreeCount);
+	SDL_DestroySemaphore(mReadyCount);
+}
+
+bool LRenderThread::start(SDL_Renderer* ren, SDL_Window* window)
+{
+	stop();
+
+	//Every frame starts out free
+	for (int i = 0; i < FRAME_COUNT; ++i)
+	{
+		mFrames[i].commands.reserve(FRAME_COMMANDS);
+		mFrames[i].commands.clear();
+		mFree.push(i);
+		SDL_SemPost(mFreeCount);
+	}
+	mRecording = -1;
+	mRenderer = ren;
+	SDL_AtomicSet(&mQuit, 0);
+	mLatency.reset();
+
+	//A GL context is current on one thread at a time, so this one lets go of it
+	mWindow = window;
+	mContext = NULL;
+	SDL_RendererInfo info;
+	if (SDL_GetRendererInfo(ren, &info) == 0 && SDL_strncmp(info.name, "opengl", 6) == 0)
+	{
+		mContext = SDL_GL_GetCurrentContext();
+		SDL_GL_MakeCurrent(window, NULL);
+	}
+
+	mThread = SDL_CreateThread(renderThread, "Render", this);
+	if (mThread == NULL)
+	{
+		printf("Unable to create render thread! SDL Error: %s\n", SDL_GetError());
+		if (mContext != NULL)
+		{
+			SDL_GL_MakeCurrent(mWindow, mContext);
+		}
+
+		//Take the free frames back, or the next start() would queue them twice
+		int slot = 0;
+		while (mFree.pop(slot))
+		{
+			SDL_SemTryWait(mFreeCount);
+		}
+		mRenderer = NULL;
+		return false;
+	}
+	return true;
+}
+
+void LRenderThread::stop()
+{
+	if (mThread == NULL)
+	{
+		return;
+	}
+
+	//The thread renders what is queued before it sees the quit flag
+	SDL_AtomicSet(&mQuit, 1);
+	SDL_SemPost(mReadyCount);
+	SDL_WaitThread(mThread, NULL);
+	mThread = NULL;
+	mRenderer = NULL;
+
+	//The thread released the context on its way out
+	if (mContext != NULL)
+	{
+		SDL_GL_MakeCurrent(mWindow, mContext);
+		mContext = NULL;
+	}
+
+	//Leave both rings and counts empty for the next start()
+	int slot = 0;
+	while (mFree.pop(slot))
+	{
+		SDL_SemTryWait(mFreeCount);
+	}
+	while (mReady.pop(slot))
+	{
+	}
+	while (SDL_SemTryWait(mReadyCount) == 0)
+	{
+	}
+	mRecording = -1;
+}
+
+bool LRenderThread::isRunning()
+{
+	return mThread != NULL;
+}
+
+LCommandList& LRenderThread::beginFrame()
+{
+	if (mRecording < 0)
+	{
+		LPROFILE_ZONE("LRenderThread::beginFrame wait");
+		SDL_SemWait(mFreeCount);
+		mFree.pop(mRecording);
+	}
+	return mFrames[mRecording].commands;
+}
+
+void LRenderThread::endFrame(Uint64 inputTime)
+{
+	if (mRecording < 0)
+	{
+		return;
+	}
+	mFrames[mRecording].inputTime = inputTime;
+	mReady.push(mRecording);
+	SDL_SemPost(mReadyCount);
+	mRecording = -1;
+}
+
+LLatencyStats& LRenderThread::getLatency()
+{
+	return mLatency;
+}
+
+int SDLCALL LRenderThread::renderThread(void* data)
+{
+	LRenderThread* thread = (LRenderThread*)data;
+	if (thread->mContext != NULL)
+	{
+		SDL_GL_MakeCurrent(thread->mWindow, thread->mContext);
+	}
+	for (;;)
+	{
+		SDL_SemWait(thread->mReadyCount);
+		int slot = 0;
+		if (!thread->mReady.pop(slot))
+		{
+			//Only stop() posts without a frame
+			if (SDL_AtomicGet(&thread->mQuit) != 0)
+			{
+				break;
+			}
+			continue;
+		}
+
+		Frame& frame = thread->mFrames[slot];
+		{
+			LPROFILE_ZONE("Render thread frame");
+			frame.commands.submit(thread->mRenderer);
+			SDL_RenderPresent(thread->mRenderer);
+		}
+		thread->mLatency.record(frame.inputTime, SDL_GetPerformanceCounter());
+		gRenderStats.endFrame();
+
+		frame.commands.clear();
+		thread->mFree.push(slot);
+		SDL_SemPost(thread->mFreeCount);
+	}
+	if (thread->mContext != NULL)
+	{
+		SDL_GL_MakeCurrent(thread->mWindow, NULL);
+	}
+	return 0;
+}
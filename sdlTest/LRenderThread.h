@@ -0,0 +1,114 @@
+#pragma once
+
+#ifndef LRENDERTHREAD_H
+#define LRENDERTHREAD_H
+
+#include "SDL.h"
+#include "LCommandList.h"
+
+//Input to present latency and frame rate, safe to record and print from different threads
+class LLatencyStats
+{
+public:
+	//Initializes variables
+	LLatencyStats();
+
+	//Counts a presented frame, inputTime is the performance counter when its input was read, 0 for none
+	void record(Uint64 inputTime, Uint64 presentTime);
+
+	//Prints frames per second and latency since the last reset
+	void print(const char* label);
+	void reset();
+
+private:
+	SDL_SpinLock mLock;
+	Uint32 mFrames;
+	Uint32 mInputs;
+	Uint64 mLatencyTicks;
+	Uint64 mMaxLatencyTicks;
+	Uint64 mFirstPresent;
+	Uint64 mLastPresent;
+};
+
+//Single producer, single consumer ring of frame slots, never allocates
+class LFrameRing
+{
+public:
+	static const int SIZE = 4;
+
+	LFrameRing();
+
+	//Producer side, false when full
+	bool push(int slot);
+
+	//Consumer side, false when empty
+	bool pop(int& slot);
+
+private:
+	int mSlots[SIZE];
+	SDL_atomic_t mHead;
+	SDL_atomic_t mTail;
+};
+
+//Optional render thread that owns the renderer while running
+//The main thread records a frame into a command list while the render thread submits and presents the previous one
+class LRenderThread
+{
+public:
+	//Frames in flight, one recording and one rendering
+	static const int FRAME_COUNT = 2;
+
+	//Initializes variables
+	LRenderThread();
+
+	//Stops the thread
+	~LRenderThread();
+
+	//Hands ren to a new render thread, the caller must not render until stop()
+	//An OpenGL renderer's context moves to the render thread and comes back to the caller in stop()
+	bool start(SDL_Renderer* ren, SDL_Window* window);
+
+	//Renders queued frames and joins the thread
+	void stop();
+
+	bool isRunning();
+
+	//Gets an empty frame to record, waits while every frame is in flight
+	LCommandList& beginFrame();
+
+	//Queues the frame from beginFrame(), inputTime as in LLatencyStats::record()
+	void endFrame(Uint64 inputTime);
+
+	LLatencyStats& getLatency();
+
+private:
+	struct Frame
+	{
+		LCommandList commands;
+		Uint64 inputTime;
+	};
+
+	static int SDLCALL renderThread(void* data);
+
+	Frame mFrames[FRAME_COUNT];
+	int mRecording;
+
+	//Recorded frames waiting to render, and rendered frames free to record
+	LFrameRing mReady;
+	LFrameRing mFree;
+	SDL_sem* mReadyCount;
+	SDL_sem* mFreeCount;
+
+	SDL_Thread* mThread;
+	SDL_Renderer* mRenderer;
+	SDL_atomic_t mQuit;
+
+	//Context released by the caller while the thread runs, NULL for renderers without one
+	SDL_Window* mWindow;
+	SDL_GLContext mContext;
+
+	LLatencyStats mLatency;
+};
+
+extern LRenderThread gRenderThread;
+#endif
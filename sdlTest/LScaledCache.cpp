@@ -0,0 +1,257 @@
+#include"LScaledCache.h"
+#include"LMemoryTracker.h"
+
+#include <stdio.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCALE_SSE2 1
+#endif
+
+LScaledCache::LScaledCache()
+{
+	//Initialize
+	mMemoryUsage = 0;
+}
+
+LScaledCache::~LScaledCache()
+{
+	//Deallocate
+	clear();
+}
+
+LScaledCache::Entry* LScaledCache::findEntry(SDL_Surface* source, int w, int h, Filter filter)
+{
+	for (size_t i = 0; i < mEntries.size(); ++i)
+	{
+		Entry& entry = mEntries[i];
+		if (entry.source == source && entry.w == w && entry.h == h && entry.filter == filter)
+		{
+			return &entry;
+		}
+	}
+	return NULL;
+}
+
+SDL_Surface* LScaledCache::getSurface(SDL_Surface* source, int w, int h, Filter filter)
+{
+	Entry* entry = findEntry(source, w, h, filter);
+	if (entry != NULL)
+	{
+		return entry->surface;
+	}
+
+	SDL_Surface* scaled = resample(source, w, h, filter);
+	if (scaled == NULL)
+	{
+		return NULL;
+	}
+	LMEMORY_TRACK_SURFACE(scaled, "scaled image");
+	Entry newEntry = { source, w, h, filter, scaled, NULL };
+	mEntries.push_back(newEntry);
+	mMemoryUsage += scaled->pitch * scaled->h;
+	return scaled;
+}
+
+SDL_Texture* LScaledCache::getTexture(SDL_Renderer* ren, SDL_Surface* source, int w, int h, Filter filter)
+{
+	if (getSurface(source, w, h, filter) == NULL)
+	{
+		return NULL;
+	}
+	Entry* entry = findEntry(source, w, h, filter);
+	if (entry->texture == NULL)
+	{
+		entry->texture = SDL_CreateTextureFromSurface(ren, entry->surface);
+		if (entry->texture == NULL)
+		{
+			printf("Unable to create scaled texture! SDL Error: %s\n", SDL_GetError());
+			return NULL;
+		}
+		LMEMORY_TRACK_TEXTURE(entry->texture, "scaled image");
+		mMemoryUsage += w * h * 4;
+	}
+	return entry->texture;
+}
+
+void LScaledCache::clear()
+{
+	for (size_t i = 0; i < mEntries.size(); ++i)
+	{
+		freeTrackedSurface(mEntries[i].surface);
+		if (mEntries[i].texture != NULL)
+		{
+			destroyTrackedTexture(mEntries[i].texture);
+		}
+	}
+	mEntries.clear();
+	mMemoryUsage = 0;
+}
+
+void LScaledCache::remove(SDL_Surface* source)
+{
+	for (size_t i = 0; i < mEntries.size();)
+	{
+		Entry& entry = mEntries[i];
+		if (entry.source != source)
+		{
+			++i;
+			continue;
+		}
+		mMemoryUsage -= entry.surface->pitch * entry.surface->h;
+		freeTrackedSurface(entry.surface);
+		if (entry.texture != NULL)
+		{
+			mMemoryUsage -= entry.w * entry.h * 4;
+			destroyTrackedTexture(entry.texture);
+		}
+		mEntries.erase(mEntries.begin() + i);
+	}
+}
+
+size_t LScaledCache::getMemoryUsage()
+{
+	return mMemoryUsage;
+}
+
+int LScaledCache::getEntryCount()
+{
+	return (int)mEntries.size();
+}
+
+//Source sample positions and 7 bit blend weights for one axis
+static void bilinearAxis(int srcSize, int dstSize, std::vector<int>& first, std::vector<int>& second, std::vector<int>& weight)
+{
+	first.resize(dstSize);
+	second.resize(dstSize);
+	weight.resize(dstSize);
+	Sint64 step = ((Sint64)srcSize << 16) / dstSize;
+	Sint64 pos = step / 2 - 0x8000;
+	for (int i = 0; i < dstSize; ++i, pos += step)
+	{
+		Sint64 clamped = pos < 0 ? 0 : pos;
+		int index = (int)(clamped >> 16);
+		if (index >= srcSize - 1)
+		{
+			index = srcSize - 1;
+			clamped = (Sint64)index << 16;
+		}
+		first[i] = index;
+		second[i] = index + 1 < srcSize ? index + 1 : index;
+		weight[i] = (int)((clamped >> 9) & 0x7F);
+	}
+}
+
+static void scaleBilinear(const SDL_Surface* src, SDL_Surface* dst)
+{
+	std::vector<int> x0, x1, fx, y0, y1, fy;
+	bilinearAxis(src->w, dst->w, x0, x1, fx);
+	bilinearAxis(src->h, dst->h, y0, y1, fy);
+
+	for (int y = 0; y < dst->h; ++y)
+	{
+		const Uint32* top = (const Uint32*)((const Uint8*)src->pixels + y0[y] * src->pitch);
+		const Uint32* bottom = (const Uint32*)((const Uint8*)src->pixels + y1[y] * src->pitch);
+		Uint32* out = (Uint32*)((Uint8*)dst->pixels + y * dst->pitch);
+#if defined(SCALE_SSE2)
+		__m128i zero = _mm_setzero_si128();
+		__m128i wy = _mm_set1_epi16((short)fy[y]);
+		for (int x = 0; x < dst->w; ++x)
+		{
+			//Both columns in one register, four 16 bit channels each
+			__m128i t = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, (int)top[x1[x]], (int)top[x0[x]]), zero);
+			__m128i b = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, (int)bottom[x1[x]], (int)bottom[x0[x]]), zero);
+			__m128i v = _mm_add_epi16(t, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(b, t), wy), 7));
+			__m128i right = _mm_srli_si128(v, 8);
+			__m128i h = _mm_add_epi16(v, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(right, v), _mm_set1_epi16((short)fx[x])), 7));
+			out[x] = (Uint32)_mm_cvtsi128_si32(_mm_packus_epi16(h, h));
+		}
+#else
+		for (int x = 0; x < dst->w; ++x)
+		{
+			Uint32 p00 = top[x0[x]], p01 = top[x1[x]], p10 = bottom[x0[x]], p11 = bottom[x1[x]];
+			Uint32 result = 0;
+			for (int shift = 0; shift < 32; shift += 8)
+			{
+				int c00 = (p00 >> shift) & 0xFF, c01 = (p01 >> shift) & 0xFF;
+				int c10 = (p10 >> shift) & 0xFF, c11 = (p11 >> shift) & 0xFF;
+				int left = c00 + (((c10 - c00) * fy[y]) >> 7);
+				int right = c01 + (((c11 - c01) * fy[y]) >> 7);
+				result |= (Uint32)(left + (((right - left) * fx[x]) >> 7)) << shift;
+			}
+			out[x] = result;
+		}
+#endif
+	}
+}
+
+static void scaleBox(const SDL_Surface* src, SDL_Surface* dst)
+{
+	for (int y = 0; y < dst->h; ++y)
+	{
+		int sy0 = y * src->h / dst->h;
+		int sy1 = SDL_max((y + 1) * src->h / dst->h, sy0 + 1);
+		Uint32* out = (Uint32*)((Uint8*)dst->pixels + y * dst->pitch);
+		for (int x = 0; x < dst->w; ++x)
+		{
+			int sx0 = x * src->w / dst->w;
+			int sx1 = SDL_max((x + 1) * src->w / dst->w, sx0 + 1);
+
+			//Average every source pixel under the destination pixel
+			Uint32 sum[4] = { 0, 0, 0, 0 };
+			for (int sy = sy0; sy < sy1; ++sy)
+			{
+				const Uint32* row = (const Uint32*)((const Uint8*)src->pixels + sy * src->pitch);
+				for (int sx = sx0; sx < sx1; ++sx)
+				{
+					Uint32 p = row[sx];
+					sum[0] += p & 0xFF;
+					sum[1] += (p >> 8) & 0xFF;
+					sum[2] += (p >> 16) & 0xFF;
+					sum[3] += p >> 24;
+				}
+			}
+			Uint32 count = (sy1 - sy0) * (sx1 - sx0);
+			out[x] = (sum[0] / count) | ((sum[1] / count) << 8) | ((sum[2] / count) << 16) | ((sum[3] / count) << 24);
+		}
+	}
+}
+
+SDL_Surface* LScaledCache::resample(SDL_Surface* source, int w, int h, Filter filter)
+{
+	if (source == NULL || w <= 0 || h <= 0)
+	{
+		return NULL;
+	}
+
+	//Work in one 32 bit format so the kernels can treat pixels as four byte channels
+	SDL_Surface* src = SDL_ConvertSurfaceFormat(source, SDL_PIXELFORMAT_ARGB8888, 0);
+	if (src == NULL)
+	{
+		printf("Unable to convert surface for scaling! SDL Error: %s\n", SDL_GetError());
+		return NULL;
+	}
+	SDL_Surface* dst = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+	if (dst == NULL)
+	{
+		printf("Unable to create scaled surface! SDL Error: %s\n", SDL_GetError());
+		SDL_FreeSurface(src);
+		return NULL;
+	}
+
+	SDL_LockSurface(src);
+	SDL_LockSurface(dst);
+	if (filter == FILTER_BOX)
+	{
+		scaleBox(src, dst);
+	}
+	else
+	{
+		scaleBilinear(src, dst);
+	}
+	SDL_UnlockSurface(dst);
+	SDL_UnlockSurface(src);
+
+	SDL_FreeSurface(src);
+	return dst;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#ifndef LSCALEDCACHE_H
+#define LSCALEDCACHE_H
+
+#include <vector>
+#include "SDL.h"
+
+//Caches resampled copies of images so stretched draws become plain copies
+class LScaledCache
+{
+public:
+	//Resampling filters
+	enum Filter
+	{
+		FILTER_BILINEAR,
+		FILTER_BOX
+	};
+
+	//Initializes variables
+	LScaledCache();
+
+	//Deallocates cached images
+	~LScaledCache();
+
+	//Gets source resampled to w x h, resampling on first use
+	//The surface is owned by the cache and stays valid until clear()
+	SDL_Surface* getSurface(SDL_Surface* source, int w, int h, Filter filter = FILTER_BILINEAR);
+
+	//Gets a texture of source resampled to w x h, to be drawn without scaling
+	SDL_Texture* getTexture(SDL_Renderer* ren, SDL_Surface* source, int w, int h, Filter filter = FILTER_BILINEAR);
+
+	//Drops every cached image, call when the window size changes
+	void clear();
+
+	//Drops cached images made from source, call before freeing it
+	void remove(SDL_Surface* source);
+
+	//Bytes held by cached surfaces and textures
+	size_t getMemoryUsage();
+	int getEntryCount();
+
+	//Resamples source into a new ARGB8888 surface of w x h
+	static SDL_Surface* resample(SDL_Surface* source, int w, int h, Filter filter);
+
+private:
+	struct Entry
+	{
+		SDL_Surface* source;
+		int w;
+		int h;
+		Filter filter;
+		SDL_Surface* surface;
+		SDL_Texture* texture;
+	};
+
+	Entry* findEntry(SDL_Surface* source, int w, int h, Filter filter);
+
+	std::vector<Entry> mEntries;
+	size_t mMemoryUsage;
+};
+#endif
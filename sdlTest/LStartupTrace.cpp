@@ -0,0 +1,96 @@
+#include"LStartupTrace.h"
+
+#include <stdio.h>
+
+LStartupTrace gStartupTrace;
+
+LStartupTrace::LStartupTrace()
+{
+	//Initialize
+	mRecording = false;
+	mThread = 0;
+	mStart = 0;
+	mFirstPresent = 0;
+	mPhaseCount = 0;
+	mDepth = 0;
+}
+
+void LStartupTrace::begin()
+{
+	mRecording = true;
+	mThread = SDL_ThreadID();
+	mStart = SDL_GetPerformanceCounter();
+	mFirstPresent = 0;
+	mPhaseCount = 0;
+	mDepth = 0;
+}
+
+int LStartupTrace::beginPhase(const char* name)
+{
+	if (!mRecording || SDL_ThreadID() != mThread)
+	{
+		return -1;
+	}
+
+	//Keep counting depth past the limit so ends still pair up
+	++mDepth;
+	if (mPhaseCount >= MAX_PHASES)
+	{
+		return -1;
+	}
+	Phase& phase = mPhases[mPhaseCount];
+	SDL_strlcpy(phase.name, name, sizeof(phase.name));
+	phase.depth = mDepth - 1;
+	phase.start = SDL_GetPerformanceCounter();
+	phase.end = 0;
+	return mPhaseCount++;
+}
+
+void LStartupTrace::endPhase(int phase)
+{
+	if (!mRecording || SDL_ThreadID() != mThread)
+	{
+		return;
+	}
+	--mDepth;
+	if (phase >= 0)
+	{
+		mPhases[phase].end = SDL_GetPerformanceCounter();
+	}
+}
+
+double LStartupTrace::getTimeToFirstPresent()
+{
+	if (mFirstPresent == 0)
+	{
+		return 0.0;
+	}
+	return (mFirstPresent - mStart) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void LStartupTrace::finish()
+{
+	mFirstPresent = SDL_GetPerformanceCounter();
+	mRecording = false;
+	printReport();
+}
+
+void LStartupTrace::printReport()
+{
+	double toMilliseconds = 1000.0 / SDL_GetPerformanceFrequency();
+	Uint64 now = mFirstPresent != 0 ? mFirstPresent : SDL_GetPerformanceCounter();
+	printf("Startup breakdown (offset, duration):\n");
+	for (int i = 0; i < mPhaseCount; ++i)
+	{
+		const Phase& phase = mPhases[i];
+		//Phases still open when the frame was presented run up to it
+		Uint64 end = phase.end != 0 ? phase.end : now;
+		printf("  %9.2f ms %9.2f ms  %*s%s%s\n", (phase.start - mStart) * toMilliseconds, (end - phase.start) * toMilliseconds,
+			phase.depth * 2, "", phase.name, phase.end != 0 ? "" : " (open)");
+	}
+	if (mPhaseCount >= MAX_PHASES)
+	{
+		printf("  (later phases dropped)\n");
+	}
+	printf("Time to first present: %.2f ms\n", getTimeToFirstPresent());
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#ifndef LSTARTUPTRACE_H
+#define LSTARTUPTRACE_H
+
+#include "SDL.h"
+
+//Times startup phases and asset loads up to the first SDL_RenderPresent, then logs a breakdown
+//Only phases on the thread that called begin() are recorded
+class LStartupTrace
+{
+public:
+	//Phases kept, later ones are dropped
+	static const int MAX_PHASES = 64;
+
+	//Initializes variables
+	LStartupTrace();
+
+	//Starts the clock, call first thing in main()
+	void begin();
+
+	//Opens and closes a phase, nested phases are indented in the report
+	//begin returns the slot to pass to end, or -1 when not recording
+	int beginPhase(const char* name);
+	void endPhase(int phase);
+
+	//Call right after presenting, the first call stops the trace and prints it
+	void presented()
+	{
+		if (mRecording)
+		{
+			finish();
+		}
+	}
+
+	//Milliseconds from begin() to the end of the first present, 0 until then
+	double getTimeToFirstPresent();
+
+	//Prints every phase with its start offset and duration
+	void printReport();
+
+private:
+	void finish();
+
+	struct Phase
+	{
+		char name[64];
+		int depth;
+		Uint64 start;
+		Uint64 end;
+	};
+
+	bool mRecording;
+	SDL_threadID mThread;
+	Uint64 mStart;
+	Uint64 mFirstPresent;
+
+	Phase mPhases[MAX_PHASES];
+	int mPhaseCount;
+	int mDepth;
+};
+
+extern LStartupTrace gStartupTrace;
+
+//Times its own scope as a startup phase
+class LStartupPhase
+{
+public:
+	explicit LStartupPhase(const char* name) : mPhase(gStartupTrace.beginPhase(name)) {}
+	~LStartupPhase() { gStartupTrace.endPhase(mPhase); }
+
+private:
+	int mPhase;
+};
+
+#define LSTARTUP_CONCAT_INNER(a, b) a##b
+#define LSTARTUP_CONCAT(a, b) LSTARTUP_CONCAT_INNER(a, b)
+//Times the rest of the enclosing scope as a startup phase, name is copied
+#define LSTARTUP_PHASE(name) LStartupPhase LSTARTUP_CONCAT(startupPhase, __LINE__)(name)
+#endif
@@ -0,0 +1,228 @@
+#include"LSurfacePool.h"
+#include"LMemoryTracker.h"
+
+#include <stdio.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+LSurfacePool gSurfacePool;
+
+//Smallest buffer handed out, tiny surfaces share one size class
+static const size_t MIN_BUCKET_SIZE = 4096;
+
+LSurfacePool::LSurfacePool()
+{
+	//Initialize
+	mAcquires = 0;
+	mAllocations = 0;
+	mPooledBytes = 0;
+	mPeakBytes = 0;
+}
+
+LSurfacePool::~LSurfacePool()
+{
+	//Deallocate
+	trim();
+}
+
+LSurfacePool::Bucket& LSurfacePool::findBucket(Uint32 format, size_t size)
+{
+	for (size_t i = 0; i < mBuckets.size(); ++i)
+	{
+		if (mBuckets[i].format == format && mBuckets[i].size == size)
+		{
+			return mBuckets[i];
+		}
+	}
+	Bucket bucket;
+	bucket.format = format;
+	bucket.size = size;
+	mBuckets.push_back(bucket);
+	return mBuckets.back();
+}
+
+static size_t bucketSize(size_t bytes)
+{
+	size_t size = MIN_BUCKET_SIZE;
+	while (size < bytes)
+	{
+		size <<= 1;
+	}
+	return size;
+}
+
+SDL_Surface* LSurfacePool::acquire(int w, int h, Uint32 format)
+{
+	int bytesPerPixel = SDL_BYTESPERPIXEL(format);
+	int pitch = (w * bytesPerPixel + 3) & ~3;
+	size_t size = bucketSize((size_t)pitch * h);
+	Bucket& bucket = findBucket(format, size);
+	++mAcquires;
+
+	void* pixels = NULL;
+	if (!bucket.idle.empty())
+	{
+		pixels = bucket.idle.back();
+		bucket.idle.pop_back();
+	}
+	else
+	{
+		pixels = SDL_malloc(size);
+		if (pixels == NULL)
+		{
+			printf("Unable to allocate %u byte surface buffer!\n", (unsigned)size);
+			return NULL;
+		}
+		++mAllocations;
+		mPooledBytes += size;
+#if LMEMORY_TRACKING
+		gMemoryTracker.track(pixels, LMemoryTracker::SURFACE, "surface pool", w, h, format, size, __FILE__, __LINE__);
+#endif
+		if (mPooledBytes > mPeakBytes)
+		{
+			mPeakBytes = mPooledBytes;
+		}
+	}
+
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(pixels, w, h, bytesPerPixel * 8, pitch, format);
+	if (surface == NULL)
+	{
+		printf("Unable to wrap pooled surface! SDL Error: %s\n", SDL_GetError());
+		bucket.idle.push_back(pixels);
+	}
+	return surface;
+}
+
+SDL_Surface* LSurfacePool::convert(SDL_Surface* source, Uint32 format)
+{
+	SDL_Surface* converted = acquire(source->w, source->h, format);
+	if (converted == NULL)
+	{
+		return NULL;
+	}
+
+	//Copy rather than blend, color keyed pixels are skipped and left transparent like SDL_ConvertSurface
+	SDL_BlendMode oldMode = SDL_BLENDMODE_NONE;
+	SDL_GetSurfaceBlendMode(source, &oldMode);
+	SDL_SetSurfaceBlendMode(source, SDL_BLENDMODE_NONE);
+	if (SDL_HasColorKey(source))
+	{
+		SDL_FillRect(converted, NULL, 0);
+	}
+	int result = SDL_BlitSurface(source, NULL, converted, NULL);
+	SDL_SetSurfaceBlendMode(source, oldMode);
+	if (result != 0)
+	{
+		printf("Unable to convert surface! SDL Error: %s\n", SDL_GetError());
+		release(converted);
+		return NULL;
+	}
+	return converted;
+}
+
+void LSurfacePool::release(SDL_Surface* surface)
+{
+	if (surface == NULL)
+	{
+		return;
+	}
+	size_t size = bucketSize((size_t)surface->pitch * surface->h);
+	findBucket(surface->format->format, size).idle.push_back(surface->pixels);
+
+	//Pooled surfaces are SDL_PREALLOC, so this frees only the surface header
+	SDL_FreeSurface(surface);
+}
+
+void LSurfacePool::trim()
+{
+	for (size_t i = 0; i < mBuckets.size(); ++i)
+	{
+		Bucket& bucket = mBuckets[i];
+		for (size_t j = 0; j < bucket.idle.size(); ++j)
+		{
+			LMEMORY_UNTRACK(bucket.idle[j]);
+			SDL_free(bucket.idle[j]);
+			mPooledBytes -= bucket.size;
+		}
+		bucket.idle.clear();
+	}
+}
+
+Uint32 LSurfacePool::getAcquireCount()
+{
+	return mAcquires;
+}
+
+Uint32 LSurfacePool::getAllocationCount()
+{
+	return mAllocations;
+}
+
+size_t LSurfacePool::getPooledBytes()
+{
+	return mPooledBytes;
+}
+
+size_t LSurfacePool::getPeakBytes()
+{
+	return mPeakBytes;
+}
+
+size_t LSurfacePool::getPeakResidentBytes()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return counters.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+#if defined(__APPLE__)
+		return (size_t)usage.ru_maxrss;
+#else
+		return (size_t)usage.ru_maxrss * 1024;
+#endif
+	}
+	return 0;
+#endif
+}
+
+size_t LSurfacePool::getResidentBytes()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return counters.WorkingSetSize;
+	}
+	return 0;
+#elif defined(__linux__)
+	//Second field of statm is resident pages
+	unsigned long size = 0;
+	unsigned long pages = 0;
+	FILE* statm = fopen("/proc/self/statm", "r");
+	if (statm == NULL)
+	{
+		return 0;
+	}
+	if (fscanf(statm, "%lu %lu", &size, &pages) != 2)
+	{
+		pages = 0;
+	}
+	fclose(statm);
+	return (size_t)pages * (size_t)sysconf(_SC_PAGESIZE);
+#else
+	return 0;
+#endif
+}
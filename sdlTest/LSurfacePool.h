@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef LSURFACEPOOL_H
+#define LSURFACEPOOL_H
+
+#include <vector>
+#include "SDL.h"
+
+//Recycles surface pixel buffers, bucketed by pixel format and power of two size
+//Surfaces from acquire() wrap pooled pixels and must be returned with release()
+//Not thread safe, use it from the thread that uploads textures
+class LSurfacePool
+{
+public:
+	//Initializes variables
+	LSurfacePool();
+
+	//Frees every pooled buffer
+	~LSurfacePool();
+
+	//Gets a w x h surface in format backed by a pooled buffer, contents are undefined
+	SDL_Surface* acquire(int w, int h, Uint32 format);
+
+	//Gets a pooled copy of source converted to format, like SDL_ConvertSurface
+	SDL_Surface* convert(SDL_Surface* source, Uint32 format);
+
+	//Frees the surface and returns its pixels to the pool
+	void release(SDL_Surface* surface);
+
+	//Frees idle buffers
+	void trim();
+
+	//Counters
+	Uint32 getAcquireCount();
+	Uint32 getAllocationCount();
+	size_t getPooledBytes();
+	size_t getPeakBytes();
+
+	//Largest resident set of the process so far, 0 if unknown
+	static size_t getPeakResidentBytes();
+
+	//Resident set of the process now, 0 if unknown
+	static size_t getResidentBytes();
+
+private:
+	struct Bucket
+	{
+		Uint32 format;
+		size_t size;
+		std::vector<void*> idle;
+	};
+
+	Bucket& findBucket(Uint32 format, size_t size);
+
+	std::vector<Bucket> mBuckets;
+
+	Uint32 mAcquires;
+	Uint32 mAllocations;
+
+	//Bytes owned by the pool, in use or idle
+	size_t mPooledBytes;
+	size_t mPeakBytes;
+};
+
+//Pool shared by the decode, conversion and text paths
+extern LSurfacePool gSurfacePool;
+#endif
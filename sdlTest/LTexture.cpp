@@ -1,80 +1,373 @@
 #include"LTexture.h"
+#include"LSurfacePool.h"
+#include"LProfiler.h"
+#include"LRenderStats.h"
+#include"LStartupTrace.h"
+#include"LAssetArchive.h"
+#include"LAssetWatcher.h"
+#include"LUploadScheduler.h"
+
+#include <utility>
+
+bool LTexture::sLazy = false;
 
 LTexture::LTexture()
 {
 	//Initialize
-	mTexture = NULL;
 	mWidth = 0;
 	mHeight = 0;
+	mRenderer = NULL;
+	mPrefetch = NULL;
+	mPriority = 0;
+	mQueued = false;
 }
 
 LTexture::~LTexture()
 {
-	//Deallocate
+	//Deallocate, other globals are only touched for state still registered with them, which close() drops before exit
 	free();
 }
 
+LTexture::LTexture(LTexture&& other) noexcept
+	: mTexture(std::move(other.mTexture)), mPath(std::move(other.mPath))
+{
+	if (mTexture)
+	{
+		gAssetWatcher.moved(&other, this);
+	}
+	mWidth = other.mWidth;
+	mHeight = other.mHeight;
+	mRenderer = other.mRenderer;
+	mPrefetch = other.mPrefetch;
+	mPriority = other.mPriority;
+	mQueued = other.mQueued;
+	if (mQueued)
+	{
+		gUploadScheduler.moved(&other, this);
+	}
+	other.mWidth = 0;
+	other.mHeight = 0;
+	other.mPath.clear();
+	other.mRenderer = NULL;
+	other.mPrefetch = NULL;
+	other.mQueued = false;
+}
+
+LTexture& LTexture::operator=(LTexture&& other) noexcept
+{
+	if (this != &other)
+	{
+		free();
+		if (other.mTexture)
+		{
+			gAssetWatcher.moved(&other, this);
+		}
+		mTexture = std::move(other.mTexture);
+		mPath = std::move(other.mPath);
+		mWidth = other.mWidth;
+		mHeight = other.mHeight;
+		mRenderer = other.mRenderer;
+		mPrefetch = other.mPrefetch;
+		mPriority = other.mPriority;
+		mQueued = other.mQueued;
+		if (mQueued)
+		{
+			gUploadScheduler.moved(&other, this);
+		}
+		other.mWidth = 0;
+		other.mHeight = 0;
+		other.mPath.clear();
+		other.mRenderer = NULL;
+		other.mPrefetch = NULL;
+		other.mQueued = false;
+	}
+	return *this;
+}
+
 bool LTexture::loadFromFile(SDL_Renderer* ren, std::string path)
 {
+	LSTARTUP_PHASE(path.c_str());
+
 	//Get rid of preexisting texture
 	free();
 
-	//The final texture
-	SDL_Texture* newTexture = NULL;
+	//Lazy textures only need their size until they are drawn
+	int w = 0;
+	int h = 0;
+	if (sLazy && gAssetArchive.getImageSize(path, &w, &h))
+	{
+		mWidth = w;
+		mHeight = h;
+		mPath = path;
+		mRenderer = ren;
+		return true;
+	}
+
+	//Scheduled textures decode on a job and upload when the frame budget allows
+	if (gUploadScheduler.isEnabled() && gAssetArchive.getImageSize(path, &w, &h))
+	{
+		mWidth = w;
+		mHeight = h;
+		gUploadScheduler.load(this, path, mPriority);
+		return true;
+	}
 
-	//Load image at specified path
-	SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+	//Load image at specified path, from the asset archive when it holds one
+	SDL_Surface* loadedSurface = gAssetArchive.loadImage(path);
 	if (loadedSurface == NULL)
 	{
 		printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+		return false;
+	}
+	if (gUploadScheduler.isEnabled())
+	{
+		mWidth = loadedSurface->w;
+		mHeight = loadedSurface->h;
+		gUploadScheduler.upload(this, loadedSurface, path, mPriority, false);
+		return true;
+	}
+
+	bool success = loadFromSurface(ren, loadedSurface, path);
+
+	//Get rid of old loaded surface
+	SDL_FreeSurface(loadedSurface);
+	return success;
+}
+
+void LTexture::setLazy(bool lazy)
+{
+	sLazy = lazy;
+}
+
+bool LTexture::isLazy()
+{
+	return sLazy;
+}
+
+void LTexture::prefetch()
+{
+	if (mPath.empty() || mPrefetch != NULL)
+	{
+		return;
+	}
+	mPrefetch = new Prefetch;
+	mPrefetch->path = mPath;
+	mPrefetch->surface = NULL;
+	SDL_AtomicSet(&mPrefetch->done.value, 0);
+	gJobSystem.run(prefetchJob, mPrefetch, &mPrefetch->done);
+}
+
+void LTexture::prefetchJob(void* data)
+{
+	Prefetch* prefetch = (Prefetch*)data;
+	prefetch->surface = gAssetArchive.loadImage(prefetch->path);
+}
+
+bool LTexture::load()
+{
+	if (mPath.empty())
+	{
+		return mTexture.get() != NULL;
+	}
+	LPROFILE_ZONE("LTexture::load");
+
+	//Taken out first so loadFromSurface() does not see a pending load
+	std::string path;
+	path.swap(mPath);
+	SDL_Surface* loadedSurface = NULL;
+	if (mPrefetch != NULL)
+	{
+		gJobSystem.wait(&mPrefetch->done);
+		loadedSurface = mPrefetch->surface;
+		delete mPrefetch;
+		mPrefetch = NULL;
+	}
+	else if (gUploadScheduler.isEnabled())
+	{
+		gUploadScheduler.load(this, path, mPriority);
+		return false;
 	}
 	else
 	{
-		//Color key image
-		SDL_SetColorKey(loadedSurface, SDL_TRUE, SDL_MapRGB(loadedSurface->format, 0, 0xFF, 0xFF));
+		loadedSurface = gAssetArchive.loadImage(path);
+	}
 
-		//Create texture from surface pixels
-		newTexture = SDL_CreateTextureFromSurface(ren, loadedSurface);
-		if (newTexture == NULL)
-		{
-			printf("Unable to create texture from %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
-		}
-		else
+	//A failed load is not retried every frame
+	if (loadedSurface == NULL)
+	{
+		printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+		mWidth = 0;
+		mHeight = 0;
+		return false;
+	}
+	if (gUploadScheduler.isEnabled())
+	{
+		gUploadScheduler.upload(this, loadedSurface, path, mPriority, false);
+		return false;
+	}
+	bool success = loadFromSurface(mRenderer, loadedSurface, path);
+	SDL_FreeSurface(loadedSurface);
+	return success;
+}
+
+void LTexture::setPriority(int priority)
+{
+	mPriority = priority;
+	if (mQueued)
+	{
+		gUploadScheduler.setPriority(this, priority);
+	}
+}
+
+int LTexture::getPriority()
+{
+	return mPriority;
+}
+
+bool LTexture::isLoaded()
+{
+	return mTexture.get() != NULL;
+}
+
+bool LTexture::loadFromSurface(SDL_Renderer* ren, SDL_Surface* loadedSurface, std::string path)
+{
+	//Get rid of preexisting texture
+	free();
+
+	//The final texture
+	SDL_Texture* newTexture = createTexture(ren, loadedSurface, path);
+	if (newTexture != NULL)
+	{
+		//Get image dimensions
+		mWidth = loadedSurface->w;
+		mHeight = loadedSurface->h;
+
+		//Reload when the file changes on disk
+		gAssetWatcher.watch(this, path);
+	}
+
+	//Return success
+	mTexture.reset(newTexture);
+	return newTexture != NULL;
+}
+
+bool LTexture::reloadFromSurface(SDL_Renderer* ren, SDL_Surface* loadedSurface, std::string path)
+{
+	LPROFILE_ZONE("LTexture::reloadFromSurface");
+
+	if (!mTexture)
+	{
+		return false;
+	}
+
+	//Same size, so the new pixels go into the existing texture and anything holding it stays valid
+	Uint32 format = SDL_PIXELFORMAT_UNKNOWN;
+	int access = 0;
+	int w = 0;
+	int h = 0;
+	SDL_QueryTexture(mTexture.get(), &format, &access, &w, &h);
+	if (w == loadedSurface->w && h == loadedSurface->h && access != SDL_TEXTUREACCESS_TARGET)
+	{
+		SDL_SetColorKey(loadedSurface, SDL_TRUE, SDL_MapRGB(loadedSurface->format, 0, 0xFF, 0xFF));
+		SDL_Surface* uploadSurface = gSurfacePool.convert(loadedSurface, format);
+		bool success = uploadSurface != NULL &&
+			renderUpdateTexture(mTexture.get(), NULL, uploadSurface->pixels, uploadSurface->pitch) == 0;
+		if (!success)
 		{
-			//Get image dimensions
-			mWidth = loadedSurface->w;
-			mHeight = loadedSurface->h;
+			printf("Unable to update texture from %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
 		}
+		gSurfacePool.release(uploadSurface);
+		return success;
+	}
 
-		//Get rid of old loaded surface
-		SDL_FreeSurface(loadedSurface);
+	//New size, the texture is recreated with the old one's modulation
+	SDL_Texture* newTexture = createTexture(ren, loadedSurface, path);
+	if (newTexture == NULL)
+	{
+		return false;
 	}
+	Uint8 r = 0xFF;
+	Uint8 g = 0xFF;
+	Uint8 b = 0xFF;
+	Uint8 alpha = 0xFF;
+	SDL_BlendMode mode = SDL_BLENDMODE_BLEND;
+	SDL_GetTextureColorMod(mTexture.get(), &r, &g, &b);
+	SDL_GetTextureAlphaMod(mTexture.get(), &alpha);
+	SDL_GetTextureBlendMode(mTexture.get(), &mode);
+	SDL_SetTextureColorMod(newTexture, r, g, b);
+	SDL_SetTextureAlphaMod(newTexture, alpha);
+	SDL_SetTextureBlendMode(newTexture, mode);
 
-	//Return success
-	mTexture = newTexture;
-	return mTexture != NULL;
+	mTexture.reset(newTexture);
+	mWidth = loadedSurface->w;
+	mHeight = loadedSurface->h;
+	return true;
+}
+
+SDL_Texture* LTexture::createTexture(SDL_Renderer* ren, SDL_Surface* loadedSurface, std::string path)
+{
+	//Color key image
+	SDL_SetColorKey(loadedSurface, SDL_TRUE, SDL_MapRGB(loadedSurface->format, 0, 0xFF, 0xFF));
+
+	//Convert into a pooled buffer in a texture format, so upload needs no temporary surface
+	SDL_Surface* uploadSurface = gSurfacePool.convert(loadedSurface, SDL_PIXELFORMAT_ARGB8888);
+
+	//Create texture from surface pixels
+	SDL_Texture* newTexture = SDL_CreateTextureFromSurface(ren, uploadSurface != NULL ? uploadSurface : loadedSurface);
+	if (newTexture == NULL)
+	{
+		printf("Unable to create texture from %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+	}
+	else
+	{
+		LMEMORY_TRACK_TEXTURE(newTexture, path.c_str());
+	}
+
+	//Return the converted copy to the pool
+	gSurfacePool.release(uploadSurface);
+	return newTexture;
 }
 
 void LTexture::free()
 {
 	//Free texture if it exists
-	if (mTexture != NULL)
+	if (mTexture)
+	{
+		gAssetWatcher.forget(this);
+		mTexture.reset();
+		mWidth = 0;
+		mHeight = 0;
+	}
+
+	//Drop a lazy load, waiting out a decode in flight
+	if (mPrefetch != NULL)
+	{
+		gJobSystem.wait(&mPrefetch->done);
+		SDL_FreeSurface(mPrefetch->surface);
+		delete mPrefetch;
+		mPrefetch = NULL;
+	}
+	bool queued = mQueued && gUploadScheduler.cancel(this);
+	if (!mPath.empty() || queued)
 	{
-		SDL_DestroyTexture(mTexture);
-		mTexture = NULL;
+		mPath.clear();
 		mWidth = 0;
 		mHeight = 0;
 	}
+	mRenderer = NULL;
 }
 
 void LTexture::setColor(Uint8 red, Uint8 green, Uint8 blue)
 {
 	//Modulate texture
-	SDL_SetTextureColorMod(mTexture, red, green, blue);
+	load();
+	renderSetTextureColorMod(mTexture.get(), red, green, blue);
 }
 
 void LTexture::render(SDL_Renderer* ren, int x, int y, SDL_Rect* clip)
 {
+	LPROFILE_ZONE("LTexture::render");
+
 	//Set rendering space and render to screen
 	SDL_Rect renderQuad = { x, y, mWidth, mHeight };
 	//Set clip rendering dimensions
@@ -84,7 +377,14 @@ void LTexture::render(SDL_Renderer* ren, int x, int y, SDL_Rect* clip)
 		renderQuad.h = clip->h;
 	}
 
-	SDL_RenderCopy(ren, mTexture, clip, &renderQuad);
+	//First draw of a lazy texture decodes it, one still waiting for its upload shows a placeholder
+	if (!load())
+	{
+		gUploadScheduler.renderPlaceholder(ren, this, &renderQuad);
+		return;
+	}
+
+	renderCopy(ren, mTexture.get(), clip, &renderQuad);
 }
 
 int LTexture::getWidth()
@@ -96,3 +396,9 @@ int LTexture::getHeight()
 {
 	return mHeight;
 }
+
+SDL_Texture* LTexture::getTexture()
+{
+	load();
+	return mTexture.get();
+}
@@ -5,6 +5,8 @@
 
 #include <iostream>
 #include "SDL_image.h"
+#include "LHandle.h"
+#include "LJobSystem.h"
 
 class LTexture
 {
@@ -15,9 +17,40 @@ public:
 	//Deallocates memory
 	~LTexture();
 
+	//Takes over another texture, leaving it empty
+	LTexture(LTexture&& other) noexcept;
+	LTexture& operator=(LTexture&& other) noexcept;
+
+	//Textures own their hardware texture and cannot be copied
+	LTexture(const LTexture&) = delete;
+	LTexture& operator=(const LTexture&) = delete;
+
 	//Loads image at specified path
+	//In lazy mode only the header is read, the image is decoded and uploaded when first drawn
+	//With gUploadScheduler on the decode runs on a job and the upload waits for the frame budget
 	bool loadFromFile(SDL_Renderer* ren, std::string path);
 
+	//Lazy mode for later loadFromFile calls, off by default
+	static void setLazy(bool lazy);
+	static bool isLazy();
+
+	//Starts decoding a lazily loaded image on the job system, so first use only uploads
+	void prefetch();
+
+	//Whether the hardware texture exists, false for lazy textures not drawn yet and queued uploads
+	bool isLoaded();
+
+	//Upload order while gUploadScheduler is on, higher goes first, applies to queued uploads too
+	void setPriority(int priority);
+	int getPriority();
+
+	//Uploads an already decoded image, the surface stays with the caller
+	bool loadFromSurface(SDL_Renderer* ren, SDL_Surface* loadedSurface, std::string path);
+
+	//Replaces the pixels of a loaded texture, updating in place when the size is unchanged
+	//Color and alpha modulation and blend mode carry over either way
+	bool reloadFromSurface(SDL_Renderer* ren, SDL_Surface* loadedSurface, std::string path);
+
 	//Deallocates texture
 	void free();
 
@@ -27,16 +60,50 @@ public:
 	//Renders texture at given point
 	void render(SDL_Renderer* ren, int x, int y, SDL_Rect* clip = NULL);
 
-	//Gets image dimensions
+	//Gets image dimensions, lazy textures know them without decoding
 	int getWidth();
 	int getHeight();
 
+	//Gets the underlying hardware texture, loading a lazy texture first
+	SDL_Texture* getTexture();
+
 private:
+	//Decode started by prefetch(), on the heap so the texture can move while it runs
+	struct Prefetch
+	{
+		std::string path;
+		SDL_Surface* surface;
+		LJobCounter done;
+	};
+
+	static void prefetchJob(void* data);
+
+	//Decodes and uploads a lazy texture, true when there is a texture afterwards
+	bool load();
+
+	//Color keys and converts loadedSurface, then creates a texture from it
+	SDL_Texture* createTexture(SDL_Renderer* ren, SDL_Surface* loadedSurface, std::string path);
+
 	//The actual hardware texture
-	SDL_Texture* mTexture;
+	LTextureHandle mTexture;
 
 	//Image dimensions
 	int mWidth;
 	int mHeight;
+
+	//Lazy texture not loaded yet: what to load and where
+	std::string mPath;
+	SDL_Renderer* mRenderer;
+	Prefetch* mPrefetch;
+
+	//Upload order with gUploadScheduler
+	int mPriority;
+
+	//Whether gUploadScheduler holds an upload for this texture, kept by the scheduler
+	//Textures that never queued one do not touch it, so globals freed before exit are safe to destroy
+	bool mQueued;
+	friend class LUploadScheduler;
+
+	static bool sLazy;
 };
 #endif
\ No newline at end of file
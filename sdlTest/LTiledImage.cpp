@@ -0,0 +1,705 @@
+#include"LTiledImage.h"
+#include"LRenderStats.h"
+#include"LProfiler.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include "SDL_image.h"
+
+//Bumped whenever the layout changes
+static const char TILED_MAGIC[4] = { 'L', 'T', 'I', 'L' };
+static const Uint32 TILED_VERSION = 1;
+
+//Key of a slot holding no tile
+static const Uint64 NO_TILE = ~(Uint64)0;
+
+//Growable memory stream for PNG encoding, data1 is the vector and data2 the position
+static Sint64 SDLCALL memorySize(SDL_RWops* context)
+{
+	return (Sint64)((std::vector<Uint8>*)context->hidden.unknown.data1)->size();
+}
+
+static Sint64 SDLCALL memorySeek(SDL_RWops* context, Sint64 offset, int whence)
+{
+	Sint64 base = whence == RW_SEEK_SET ? 0 : whence == RW_SEEK_CUR ? (Sint64)(size_t)context->hidden.unknown.data2 : memorySize(context);
+	if (base + offset < 0)
+	{
+		return SDL_SetError("Seek before the start of a memory stream");
+	}
+	context->hidden.unknown.data2 = (void*)(size_t)(base + offset);
+	return base + offset;
+}
+
+static size_t SDLCALL memoryRead(SDL_RWops*, void*, size_t, size_t)
+{
+	return 0;
+}
+
+static size_t SDLCALL memoryWrite(SDL_RWops* context, const void* ptr, size_t size, size_t num)
+{
+	std::vector<Uint8>& data = *(std::vector<Uint8>*)context->hidden.unknown.data1;
+	size_t position = (size_t)context->hidden.unknown.data2;
+	size_t bytes = size * num;
+	if (data.size() < position + bytes)
+	{
+		data.resize(position + bytes);
+	}
+	SDL_memcpy(data.data() + position, ptr, bytes);
+	context->hidden.unknown.data2 = (void*)(position + bytes);
+	return num;
+}
+
+static int SDLCALL memoryClose(SDL_RWops* context)
+{
+	SDL_FreeRW(context);
+	return 0;
+}
+
+//PNG bytes of surface appended to data
+static bool encodeTile(SDL_Surface* surface, std::vector<Uint8>& data)
+{
+	SDL_RWops* stream = SDL_AllocRW();
+	if (stream == NULL)
+	{
+		return false;
+	}
+	stream->size = memorySize;
+	stream->seek = memorySeek;
+	stream->read = memoryRead;
+	stream->write = memoryWrite;
+	stream->close = memoryClose;
+	stream->type = SDL_RWOPS_UNKNOWN;
+	stream->hidden.unknown.data1 = &data;
+	stream->hidden.unknown.data2 = NULL;
+	return IMG_SavePNG_RW(surface, stream, 1) == 0;
+}
+
+//Decoded tile as ARGB8888, NULL on failure
+static SDL_Surface* decodeTile(const Uint8* data, size_t size)
+{
+	SDL_Surface* surface = IMG_LoadTyped_RW(SDL_RWFromConstMem(data, (int)size), 1, "PNG");
+	if (surface != NULL && surface->format->format != SDL_PIXELFORMAT_ARGB8888)
+	{
+		SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+		SDL_FreeSurface(surface);
+		surface = converted;
+	}
+	return surface;
+}
+
+LTiledImage::LTiledImage()
+{
+	//Initialize
+	mEntries = NULL;
+	mWidth = 0;
+	mHeight = 0;
+	mCacheBytes = DEFAULT_CACHE_BYTES;
+	mFrame = 0;
+	mDecodes = 0;
+	mReadyLock = SDL_CreateMutex();
+	SDL_AtomicSet(&mDecoding.value, 0);
+}
+
+LTiledImage::~LTiledImage()
+{
+	//Deallocate
+	close();
+	SDL_DestroyMutex(mReadyLock);
+}
+
+bool LTiledImage::open(std::string path)
+{
+	close();
+
+	if (!mFile.open(path, false))
+	{
+		printf("Unable to open tiled image %s\n", path.c_str());
+		return false;
+	}
+
+	//Everything the index points at must lie inside the file
+	const Uint8* data = mFile.getData();
+	size_t size = mFile.getSize();
+	Header header;
+	bool valid = size >= sizeof(Header);
+	if (valid)
+	{
+		SDL_memcpy(&header, data, sizeof(Header));
+		valid = SDL_memcmp(header.magic, TILED_MAGIC, sizeof(TILED_MAGIC)) == 0 && header.version == TILED_VERSION &&
+			header.tileSize == TILE_SIZE && header.width > 0 && header.height > 0 &&
+			header.width <= SDL_MAX_SINT32 && header.height <= SDL_MAX_SINT32;
+	}
+	if (valid)
+	{
+		mLevels = getLevels((int)header.width, (int)header.height);
+		const Level& top = mLevels.back();
+		valid = header.levelCount == mLevels.size() && header.tileCount == (Uint32)(top.firstTile + top.columns * top.rows) &&
+			sizeof(Header) + (Uint64)header.tileCount * sizeof(TileEntry) <= size;
+	}
+	if (valid)
+	{
+		mEntries = (const TileEntry*)(data + sizeof(Header));
+		for (Uint32 i = 0; i < header.tileCount && valid; ++i)
+		{
+			valid = mEntries[i].size > 0 && mEntries[i].offset <= size && mEntries[i].size <= size - mEntries[i].offset;
+		}
+	}
+	if (!valid)
+	{
+		printf("Tiled image %s is malformed\n", path.c_str());
+		close();
+		return false;
+	}
+	mWidth = (int)header.width;
+	mHeight = (int)header.height;
+
+	//Decodes waiting for upload count against the cap too
+	size_t tileBytes = (size_t)TILE_SIZE * TILE_SIZE * 4;
+	size_t slotCount = mCacheBytes / tileBytes > (size_t)MAX_DECODES + 4 ? mCacheBytes / tileBytes - MAX_DECODES : 4;
+	mSlots.resize(slotCount);
+	for (size_t i = 0; i < mSlots.size(); ++i)
+	{
+		mSlots[i].key = NO_TILE;
+		mSlots[i].w = 0;
+		mSlots[i].h = 0;
+		mSlots[i].lastUsed = 0;
+	}
+	mSlotOfTile.reserve(slotCount);
+	mFrame = 0;
+	mDecodes = 0;
+	return true;
+}
+
+void LTiledImage::close()
+{
+	gJobSystem.wait(&mDecoding);
+	SDL_LockMutex(mReadyLock);
+	mDecoded.insert(mDecoded.end(), mReady.begin(), mReady.end());
+	mReady.clear();
+	SDL_UnlockMutex(mReadyLock);
+	for (size_t i = 0; i < mDecoded.size(); ++i)
+	{
+		SDL_FreeSurface(mDecoded[i]->surface);
+		delete mDecoded[i];
+	}
+	mDecoded.clear();
+
+	mSlots.clear();
+	mSlotOfTile.clear();
+	mInFlight.clear();
+	mFailed.clear();
+	mRequests.clear();
+	mLevels.clear();
+	mEntries = NULL;
+	mWidth = 0;
+	mHeight = 0;
+	mFile.close();
+}
+
+bool LTiledImage::isOpen()
+{
+	return mEntries != NULL;
+}
+
+void LTiledImage::setCacheBytes(size_t bytes)
+{
+	mCacheBytes = bytes;
+}
+
+int LTiledImage::getWidth()
+{
+	return mWidth;
+}
+
+int LTiledImage::getHeight()
+{
+	return mHeight;
+}
+
+int LTiledImage::getLevelCount()
+{
+	return (int)mLevels.size();
+}
+
+void LTiledImage::render(SDL_Renderer* ren, double x, double y, double zoom, const SDL_Rect* dst)
+{
+	if (!isOpen() || zoom <= 0.0)
+	{
+		return;
+	}
+	LPROFILE_ZONE("LTiledImage::render");
+	++mFrame;
+	uploadTiles(ren);
+	mRequests.clear();
+
+	//Finest level drawn at half size or more, the renderer filters the rest
+	int level = 0;
+	double scale = zoom;
+	while (level + 1 < (int)mLevels.size() && scale <= 0.5)
+	{
+		++level;
+		scale *= 2.0;
+	}
+	const Level& grid = mLevels[level];
+	double levelX = ldexp(x, -level);
+	double levelY = ldexp(y, -level);
+	double viewW = dst->w / scale;
+	double viewH = dst->h / scale;
+	int firstColumn = (int)SDL_max(0.0, floor(levelX / TILE_SIZE));
+	int firstRow = (int)SDL_max(0.0, floor(levelY / TILE_SIZE));
+	int lastColumn = (int)SDL_min(grid.columns - 1.0, floor((levelX + viewW) / TILE_SIZE));
+	int lastRow = (int)SDL_min(grid.rows - 1.0, floor((levelY + viewH) / TILE_SIZE));
+	double centerColumn = (levelX + viewW * 0.5) / TILE_SIZE - 0.5;
+	double centerRow = (levelY + viewH * 0.5) / TILE_SIZE - 0.5;
+
+	//Tiles reaching past dst are cut off there
+	SDL_Rect oldClip;
+	bool clipped = SDL_RenderIsClipEnabled(ren) == SDL_TRUE;
+	SDL_RenderGetClipRect(ren, &oldClip);
+	renderSetClipRect(ren, dst);
+
+	for (int row = firstRow; row <= lastRow; ++row)
+	{
+		for (int column = firstColumn; column <= lastColumn; ++column)
+		{
+			//Edges rounded on their own so neighbouring tiles meet without gaps
+			int tileW = SDL_min(TILE_SIZE, grid.width - column * TILE_SIZE);
+			int tileH = SDL_min(TILE_SIZE, grid.height - row * TILE_SIZE);
+			int left = dst->x + (int)floor((column * TILE_SIZE - levelX) * scale + 0.5);
+			int top = dst->y + (int)floor((row * TILE_SIZE - levelY) * scale + 0.5);
+			int right = dst->x + (int)floor((column * TILE_SIZE + tileW - levelX) * scale + 0.5);
+			int bottom = dst->y + (int)floor((row * TILE_SIZE + tileH - levelY) * scale + 0.5);
+			SDL_Rect tileRect = { left, top, right - left, bottom - top };
+
+			double dx = column - centerColumn;
+			double dy = row - centerRow;
+			Request request = { makeKey(level, column, row), dx * dx + dy * dy };
+			mRequests.push_back(request);
+			drawTile(ren, level, column, row, tileRect);
+		}
+	}
+	renderSetClipRect(ren, clipped ? &oldClip : NULL);
+
+	//Prefetch after everything visible: the ring around the view, then the coarser level for zooming out
+	for (int row = firstRow - 1; row <= lastRow + 1; ++row)
+	{
+		for (int column = firstColumn - 1; column <= lastColumn + 1; ++column)
+		{
+			bool inside = row >= firstRow && row <= lastRow && column >= firstColumn && column <= lastColumn;
+			if (!inside && row >= 0 && row < grid.rows && column >= 0 && column < grid.columns)
+			{
+				double dx = column - centerColumn;
+				double dy = row - centerRow;
+				Request request = { makeKey(level, column, row), 1e6 + dx * dx + dy * dy };
+				mRequests.push_back(request);
+			}
+		}
+	}
+	if (level + 1 < (int)mLevels.size())
+	{
+		for (int row = firstRow / 2; row <= lastRow / 2; ++row)
+		{
+			for (int column = firstColumn / 2; column <= lastColumn / 2; ++column)
+			{
+				Request request = { makeKey(level + 1, column, row), 2e6 };
+				mRequests.push_back(request);
+			}
+		}
+	}
+
+	//The single coarsest tile always backs everything else
+	Request top = { makeKey((int)mLevels.size() - 1, 0, 0), -1.0 };
+	mRequests.push_back(top);
+	startDecodes();
+}
+
+size_t LTiledImage::getResidentBytes()
+{
+	size_t tileBytes = (size_t)TILE_SIZE * TILE_SIZE * 4;
+	size_t textures = 0;
+	for (size_t i = 0; i < mSlots.size(); ++i)
+	{
+		if (mSlots[i].texture)
+		{
+			++textures;
+		}
+	}
+	return (textures + mInFlight.size()) * tileBytes;
+}
+
+Uint32 LTiledImage::getDecodeCount()
+{
+	return mDecodes;
+}
+
+void LTiledImage::drawTile(SDL_Renderer* ren, int level, int column, int row, const SDL_Rect& dst)
+{
+	Slot* slot = findTile(makeKey(level, column, row));
+	if (slot != NULL)
+	{
+		SDL_Rect src = { 0, 0, slot->w, slot->h };
+		renderCopy(ren, slot->texture.get(), &src, &dst);
+		return;
+	}
+
+	//Stand in with the matching part of a coarser tile, blurry until the real one lands
+	for (int coarser = level + 1; coarser < (int)mLevels.size(); ++coarser)
+	{
+		int shift = coarser - level;
+		int parentColumn = column >> shift;
+		int parentRow = row >> shift;
+		Slot* parent = findTile(makeKey(coarser, parentColumn, parentRow));
+		if (parent == NULL)
+		{
+			continue;
+		}
+		const Level& grid = mLevels[level];
+		int tileW = SDL_min(TILE_SIZE, grid.width - column * TILE_SIZE);
+		int tileH = SDL_min(TILE_SIZE, grid.height - row * TILE_SIZE);
+		double left = ldexp(column * TILE_SIZE, -shift) - parentColumn * TILE_SIZE;
+		double top = ldexp(row * TILE_SIZE, -shift) - parentRow * TILE_SIZE;
+		SDL_Rect src;
+		src.x = (int)left;
+		src.y = (int)top;
+		src.w = SDL_max(1, SDL_min(parent->w - src.x, (int)ceil(ldexp(tileW, -shift))));
+		src.h = SDL_max(1, SDL_min(parent->h - src.y, (int)ceil(ldexp(tileH, -shift))));
+		renderCopy(ren, parent->texture.get(), &src, &dst);
+		return;
+	}
+}
+
+LTiledImage::Slot* LTiledImage::findTile(Uint64 key)
+{
+	std::unordered_map<Uint64, int>::iterator found = mSlotOfTile.find(key);
+	if (found == mSlotOfTile.end())
+	{
+		return NULL;
+	}
+	Slot* slot = &mSlots[found->second];
+	slot->lastUsed = mFrame;
+	return slot;
+}
+
+void LTiledImage::uploadTiles(SDL_Renderer* ren)
+{
+	//Never wait on the decoders, anything locked now is uploaded next frame
+	if (SDL_TryLockMutex(mReadyLock) == 0)
+	{
+		mDecoded.insert(mDecoded.end(), mReady.begin(), mReady.end());
+		mReady.clear();
+		SDL_UnlockMutex(mReadyLock);
+	}
+
+	Uint64 topKey = makeKey((int)mLevels.size() - 1, 0, 0);
+	int uploads = 0;
+	while (!mDecoded.empty() && uploads < MAX_UPLOADS)
+	{
+		Decode* decode = mDecoded.front();
+		mDecoded.erase(mDecoded.begin());
+		mInFlight.erase(decode->key);
+		SDL_Surface* surface = decode->surface;
+		Uint64 key = decode->key;
+		delete decode;
+		if (surface == NULL)
+		{
+			mFailed.insert(key);
+			continue;
+		}
+
+		//Least recently drawn slot, never one drawn this frame or the coarsest tile
+		int victim = -1;
+		for (size_t i = 0; i < mSlots.size(); ++i)
+		{
+			const Slot& slot = mSlots[i];
+			if (slot.key != topKey && (slot.lastUsed != mFrame || slot.key == NO_TILE) &&
+				(victim < 0 || slot.lastUsed < mSlots[victim].lastUsed))
+			{
+				victim = (int)i;
+			}
+		}
+		if (victim < 0)
+		{
+			//Cache is too small for the view, asked for again next frame
+			SDL_FreeSurface(surface);
+			continue;
+		}
+
+		Slot& slot = mSlots[victim];
+		if (!slot.texture)
+		{
+			SDL_Texture* texture = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, TILE_SIZE, TILE_SIZE);
+			if (texture == NULL)
+			{
+				printf("Unable to create tile texture! SDL Error: %s\n", SDL_GetError());
+				SDL_FreeSurface(surface);
+				continue;
+			}
+			LMEMORY_TRACK_TEXTURE(texture, "tile");
+			slot.texture.reset(texture);
+		}
+		if (slot.key != NO_TILE)
+		{
+			mSlotOfTile.erase(slot.key);
+		}
+		SDL_Rect rect = { 0, 0, surface->w, surface->h };
+		renderUpdateTexture(slot.texture.get(), &rect, surface->pixels, surface->pitch);
+		slot.key = key;
+		slot.w = surface->w;
+		slot.h = surface->h;
+		slot.lastUsed = mFrame;
+		mSlotOfTile[key] = victim;
+		SDL_FreeSurface(surface);
+		++uploads;
+		++mDecodes;
+	}
+}
+
+void LTiledImage::startDecodes()
+{
+	std::sort(mRequests.begin(), mRequests.end(), [](const Request& a, const Request& b) { return a.distance < b.distance; });
+	for (size_t i = 0; i < mRequests.size() && mInFlight.size() < (size_t)MAX_DECODES; ++i)
+	{
+		Uint64 key = mRequests[i].key;
+		if (mSlotOfTile.count(key) > 0 || mInFlight.count(key) > 0 || mFailed.count(key) > 0)
+		{
+			continue;
+		}
+		int level = (int)(key >> 48);
+		int row = (int)((key >> 24) & 0xFFFFFF);
+		int column = (int)(key & 0xFFFFFF);
+		const Level& grid = mLevels[level];
+		const TileEntry& entry = mEntries[grid.firstTile + row * grid.columns + column];
+
+		Decode* decode = new Decode;
+		decode->image = this;
+		decode->key = key;
+		decode->data = mFile.getData() + entry.offset;
+		decode->size = entry.size;
+		decode->surface = NULL;
+		mInFlight.insert(key);
+		gJobSystem.run(decodeJob, decode, &mDecoding);
+	}
+}
+
+void LTiledImage::decodeJob(void* data)
+{
+	Decode* decode = (Decode*)data;
+	decode->surface = decodeTile(decode->data, decode->size);
+
+	LTiledImage* image = decode->image;
+	SDL_LockMutex(image->mReadyLock);
+	image->mReady.push_back(decode);
+	SDL_UnlockMutex(image->mReadyLock);
+}
+
+std::vector<LTiledImage::Level> LTiledImage::getLevels(int width, int height)
+{
+	std::vector<Level> levels;
+	int firstTile = 0;
+	for (;;)
+	{
+		Level level;
+		level.width = width;
+		level.height = height;
+		level.columns = (width + TILE_SIZE - 1) / TILE_SIZE;
+		level.rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+		level.firstTile = firstTile;
+		levels.push_back(level);
+		firstTile += level.columns * level.rows;
+		if (width <= TILE_SIZE && height <= TILE_SIZE)
+		{
+			return levels;
+		}
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+	}
+}
+
+Uint64 LTiledImage::makeKey(int level, int column, int row)
+{
+	return ((Uint64)level << 48) | ((Uint64)row << 24) | (Uint64)column;
+}
+
+bool LTiledImage::build(std::string path, int width, int height, SourceFunc source, void* userdata)
+{
+	if (width <= 0 || height <= 0)
+	{
+		printf("Unable to tile a %dx%d image\n", width, height);
+		return false;
+	}
+	std::vector<Level> levels = getLevels(width, height);
+	const Level& top = levels.back();
+	std::vector<TileEntry> entries(top.firstTile + top.columns * top.rows);
+
+	//Magic goes in last, so an interrupted build never opens
+	Header header;
+	SDL_memset(&header, 0, sizeof(header));
+	header.version = TILED_VERSION;
+	header.width = width;
+	header.height = height;
+	header.tileSize = TILE_SIZE;
+	header.levelCount = (Uint32)levels.size();
+	header.tileCount = (Uint32)entries.size();
+	SDL_RWops* file = SDL_RWFromFile(path.c_str(), "wb");
+	if (file == NULL)
+	{
+		printf("Unable to create %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+		return false;
+	}
+	bool success = SDL_RWwrite(file, &header, sizeof(header), 1) == 1 &&
+		SDL_RWwrite(file, entries.data(), sizeof(TileEntry), entries.size()) == entries.size();
+	SDL_RWclose(file);
+
+	//Level by level, each built from the finished one below through a mapping of the file so far
+	for (size_t level = 0; level < levels.size() && success; ++level)
+	{
+		LMappedFile previous;
+		if (level > 0 && !previous.open(path, false))
+		{
+			success = false;
+			break;
+		}
+		file = SDL_RWFromFile(path.c_str(), "r+b");
+		success = file != NULL && SDL_RWseek(file, 0, RW_SEEK_END) >= 0;
+
+		const Level& grid = levels[level];
+		std::vector<std::vector<Uint8> > encoded(grid.columns);
+		for (int row = 0; row < grid.rows && success; ++row)
+		{
+			BuildRow work;
+			work.level = (int)level;
+			work.row = row;
+			work.levels = &levels;
+			work.fileData = previous.getData();
+			work.entries = entries.data();
+			work.source = source;
+			work.userdata = userdata;
+			work.encoded = &encoded;
+			SDL_AtomicSet(&work.failed, 0);
+			gJobSystem.parallelFor(grid.columns, 1, buildTiles, &work);
+			success = SDL_AtomicGet(&work.failed) == 0;
+
+			//Appended in column order so the file is the same on every run
+			for (int column = 0; column < grid.columns && success; ++column)
+			{
+				TileEntry& entry = entries[grid.firstTile + row * grid.columns + column];
+				entry.offset = (Uint64)SDL_RWtell(file);
+				entry.size = (Uint32)encoded[column].size();
+				entry.reserved = 0;
+				success = SDL_RWwrite(file, encoded[column].data(), 1, encoded[column].size()) == encoded[column].size();
+				std::vector<Uint8>().swap(encoded[column]);
+			}
+		}
+		if (file != NULL)
+		{
+			SDL_RWclose(file);
+		}
+	}
+
+	if (success)
+	{
+		SDL_memcpy(header.magic, TILED_MAGIC, sizeof(TILED_MAGIC));
+		file = SDL_RWFromFile(path.c_str(), "r+b");
+		success = file != NULL && SDL_RWwrite(file, &header, sizeof(header), 1) == 1 &&
+			SDL_RWwrite(file, entries.data(), sizeof(TileEntry), entries.size()) == entries.size();
+		if (file != NULL)
+		{
+			SDL_RWclose(file);
+		}
+	}
+	if (!success)
+	{
+		printf("Unable to write tiled image %s\n", path.c_str());
+	}
+	return success;
+}
+
+void LTiledImage::buildTiles(int begin, int end, void* data)
+{
+	BuildRow* work = (BuildRow*)data;
+	const std::vector<Level>& levels = *work->levels;
+	const Level& grid = levels[work->level];
+	for (int column = begin; column < end; ++column)
+	{
+		int tileW = SDL_min(TILE_SIZE, grid.width - column * TILE_SIZE);
+		int tileH = SDL_min(TILE_SIZE, grid.height - work->row * TILE_SIZE);
+
+		//Tiles are opaque, whatever the source leaves in the top byte is ignored
+		SDL_Surface* tile = SDL_CreateRGBSurfaceWithFormat(0, tileW, tileH, 32, SDL_PIXELFORMAT_RGB888);
+		if (tile == NULL)
+		{
+			SDL_AtomicSet(&work->failed, 1);
+			return;
+		}
+		if (work->level == 0)
+		{
+			work->source(column * TILE_SIZE, work->row * TILE_SIZE, tileW, tileH, (Uint32*)tile->pixels, tile->pitch / 4, work->userdata);
+		}
+		else if (!downsampleTile(levels[work->level - 1], work->fileData, work->entries, column, work->row, tile))
+		{
+			SDL_AtomicSet(&work->failed, 1);
+		}
+
+		(*work->encoded)[column].clear();
+		if (!encodeTile(tile, (*work->encoded)[column]))
+		{
+			printf("Unable to encode tile! SDL_image Error: %s\n", IMG_GetError());
+			SDL_AtomicSet(&work->failed, 1);
+		}
+		SDL_FreeSurface(tile);
+	}
+}
+
+bool LTiledImage::downsampleTile(const Level& finer, const Uint8* fileData, const TileEntry* entries, int column, int row, SDL_Surface* tile)
+{
+	//The four finer tiles under this one, side by side in one block
+	int blockW = SDL_min(2 * TILE_SIZE, finer.width - 2 * column * TILE_SIZE);
+	int blockH = SDL_min(2 * TILE_SIZE, finer.height - 2 * row * TILE_SIZE);
+	std::vector<Uint32> block((size_t)blockW * blockH);
+	for (int child = 0; child < 4; ++child)
+	{
+		int childColumn = 2 * column + (child & 1);
+		int childRow = 2 * row + (child >> 1);
+		if (childColumn >= finer.columns || childRow >= finer.rows)
+		{
+			continue;
+		}
+		const TileEntry& entry = entries[finer.firstTile + childRow * finer.columns + childColumn];
+		SDL_Surface* surface = decodeTile(fileData + entry.offset, entry.size);
+		if (surface == NULL)
+		{
+			printf("Unable to decode tile! SDL_image Error: %s\n", IMG_GetError());
+			return false;
+		}
+		for (int y = 0; y < surface->h; ++y)
+		{
+			const Uint32* src = (const Uint32*)((const Uint8*)surface->pixels + (size_t)y * surface->pitch);
+			Uint32* dst = &block[((size_t)(child >> 1) * TILE_SIZE + y) * blockW + (child & 1) * TILE_SIZE];
+			SDL_memcpy(dst, src, (size_t)surface->w * 4);
+		}
+		SDL_FreeSurface(surface);
+	}
+
+	//2x2 box filter, odd edges repeat their last row or column
+	for (int y = 0; y < tile->h; ++y)
+	{
+		const Uint32* row0 = &block[(size_t)(2 * y) * blockW];
+		const Uint32* row1 = &block[(size_t)SDL_min(2 * y + 1, blockH - 1) * blockW];
+		Uint32* dst = (Uint32*)((Uint8*)tile->pixels + (size_t)y * tile->pitch);
+		for (int x = 0; x < tile->w; ++x)
+		{
+			int x0 = 2 * x;
+			int x1 = SDL_min(2 * x + 1, blockW - 1);
+			Uint32 a = row0[x0];
+			Uint32 b = row0[x1];
+			Uint32 c = row1[x0];
+			Uint32 d = row1[x1];
+			Uint32 red = (((a >> 16) & 0xFF) + ((b >> 16) & 0xFF) + ((c >> 16) & 0xFF) + ((d >> 16) & 0xFF) + 2) / 4;
+			Uint32 green = (((a >> 8) & 0xFF) + ((b >> 8) & 0xFF) + ((c >> 8) & 0xFF) + ((d >> 8) & 0xFF) + 2) / 4;
+			Uint32 blue = ((a & 0xFF) + (b & 0xFF) + (c & 0xFF) + (d & 0xFF) + 2) / 4;
+			dst[x] = (red << 16) | (green << 8) | blue;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#ifndef LTILEDIMAGE_H
+#define LTILEDIMAGE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "SDL.h"
+#include "LHandle.h"
+#include "LJobSystem.h"
+#include "LMappedFile.h"
+
+//Images too large for one texture, split into PNG tiles with halved pyramid levels down to a single tile
+//Layout: header, one index entry per tile of every level, finest level first and rows top to bottom, then tile data
+//Only tiles near the viewport are decoded, on the job system, into a fixed pool of tile textures
+class LTiledImage
+{
+public:
+	//Edge length of a tile in pixels
+	static const int TILE_SIZE = 256;
+
+	//Memory cap for tile textures and decoded tiles waiting for upload
+	static const size_t DEFAULT_CACHE_BYTES = 64 * 1024 * 1024;
+
+	//Tile decodes in flight at once, so a fast pan does not queue work for tiles long gone
+	static const int MAX_DECODES = 8;
+
+	//Uploads per frame
+	static const int MAX_UPLOADS = 4;
+
+	//Fills a block of the full resolution image as 0xRRGGBB pixels, pitch counted in pixels, called from job threads
+	typedef void (*SourceFunc)(int x, int y, int w, int h, Uint32* pixels, int pitch, void* userdata);
+
+	//Initializes variables
+	LTiledImage();
+
+	//Waits for decodes and frees the tiles
+	~LTiledImage();
+
+	//Tiled images own textures and a mapping and cannot be copied
+	LTiledImage(const LTiledImage&) = delete;
+	LTiledImage& operator=(const LTiledImage&) = delete;
+
+	//Maps a file written by build()
+	bool open(std::string path);
+
+	//Waits for decodes in flight and frees every tile texture
+	void close();
+	bool isOpen();
+
+	//Memory cap, takes effect at the next open()
+	void setCacheBytes(size_t bytes);
+
+	//Full resolution size
+	int getWidth();
+	int getHeight();
+	int getLevelCount();
+
+	//Draws the image scaled by zoom, screen pixels per image pixel, with image point (x, y) at the top left of dst
+	//Tiles not decoded yet show the nearest coarser level that is
+	void render(SDL_Renderer* ren, double x, double y, double zoom, const SDL_Rect* dst);
+
+	//Bytes of tile textures and decoded tiles right now, never above the cap
+	size_t getResidentBytes();
+
+	//Tiles decoded since open()
+	Uint32 getDecodeCount();
+
+	//Writes a tiled image of width by height pixels, pulling the full resolution pixels from source
+	static bool build(std::string path, int width, int height, SourceFunc source, void* userdata);
+
+private:
+	struct Header
+	{
+		char magic[4];
+		Uint32 version;
+		Uint32 width;
+		Uint32 height;
+		Uint32 tileSize;
+		Uint32 levelCount;
+		Uint32 tileCount;
+		Uint32 reserved;
+	};
+
+	struct TileEntry
+	{
+		Uint64 offset;
+		Uint32 size;
+		Uint32 reserved;
+	};
+
+	//Tile grid of one pyramid level
+	struct Level
+	{
+		int width;
+		int height;
+		int columns;
+		int rows;
+		int firstTile;
+	};
+
+	//One tile texture, reused for whichever tile it holds
+	struct Slot
+	{
+		LTextureHandle texture;
+		Uint64 key;
+		int w;
+		int h;
+		Uint32 lastUsed;
+	};
+
+	struct Decode
+	{
+		LTiledImage* image;
+		Uint64 key;
+		const Uint8* data;
+		size_t size;
+		SDL_Surface* surface;
+	};
+
+	//A tile wanted this frame, lower distance decodes first
+	struct Request
+	{
+		Uint64 key;
+		double distance;
+	};
+
+	//Work of one tile row while building
+	struct BuildRow
+	{
+		int level;
+		int row;
+		const std::vector<Level>* levels;
+		const Uint8* fileData;
+		const TileEntry* entries;
+		SourceFunc source;
+		void* userdata;
+		std::vector<std::vector<Uint8> >* encoded;
+		SDL_atomic_t failed;
+	};
+
+	static void decodeJob(void* data);
+
+	//Fills, or downsamples from the finer level, and encodes tiles begin to end of a row
+	static void buildTiles(int begin, int end, void* data);
+	static bool downsampleTile(const Level& finer, const Uint8* fileData, const TileEntry* entries, int column, int row, SDL_Surface* tile);
+
+	//Levels of a width by height image
+	static std::vector<Level> getLevels(int width, int height);
+
+	static Uint64 makeKey(int level, int column, int row);
+
+	//Tile texture holding key and marks it used this frame, NULL if not resident
+	Slot* findTile(Uint64 key);
+
+	//Draws the part of tile (level, column, row) covering dst, from it or the nearest resident coarser tile
+	void drawTile(SDL_Renderer* ren, int level, int column, int row, const SDL_Rect& dst);
+
+	//Uploads finished decodes and starts decodes for this frame's requests
+	void uploadTiles(SDL_Renderer* ren);
+	void startDecodes();
+
+	LMappedFile mFile;
+	const TileEntry* mEntries;
+	std::vector<Level> mLevels;
+	int mWidth;
+	int mHeight;
+
+	size_t mCacheBytes;
+	std::vector<Slot> mSlots;
+	std::unordered_map<Uint64, int> mSlotOfTile;
+	Uint32 mFrame;
+
+	//Requested until uploaded, main thread only
+	std::unordered_set<Uint64> mInFlight;
+	std::unordered_set<Uint64> mFailed;
+	std::vector<Request> mRequests;
+	Uint32 mDecodes;
+
+	//Finished by jobs, uploaded by render()
+	SDL_mutex* mReadyLock;
+	std::vector<Decode*> mReady;
+	std::vector<Decode*> mDecoded;
+	LJobCounter mDecoding;
+};
+#endif
@@ -0,0 +1,308 @@
+#include"LUploadScheduler.h"
+#include"LTexture.h"
+#include"LAssetArchive.h"
+#include"LRenderStats.h"
+#include"LProfiler.h"
+
+#include <stdio.h>
+
+LUploadScheduler gUploadScheduler;
+
+LUploadScheduler::LUploadScheduler()
+{
+	//Initialize
+	mSequence = 0;
+	mBudgetBytes = 0;
+	mBudgetMicroseconds = 0;
+	mFrameBytes = 0;
+	mFrameMs = 0.0;
+}
+
+LUploadScheduler::~LUploadScheduler()
+{
+	//Deallocate
+	clear();
+}
+
+void LUploadScheduler::setBudget(size_t bytes, Uint32 microseconds)
+{
+	mBudgetBytes = bytes;
+	mBudgetMicroseconds = microseconds;
+}
+
+bool LUploadScheduler::isEnabled()
+{
+	return mBudgetBytes > 0 || mBudgetMicroseconds > 0;
+}
+
+void LUploadScheduler::load(LTexture* texture, const std::string& path, int priority)
+{
+	cancel(texture);
+
+	Upload* upload = new Upload;
+	upload->texture = texture;
+	upload->path = path;
+	upload->surface = NULL;
+	SDL_AtomicSet(&upload->decoding.value, 0);
+	upload->priority = priority;
+	upload->drawn = false;
+	upload->reload = false;
+	upload->sequence = mSequence++;
+	mQueue.push_back(upload);
+	texture->mQueued = true;
+	gJobSystem.run(decodeJob, upload, &upload->decoding);
+}
+
+void LUploadScheduler::upload(LTexture* texture, SDL_Surface* surface, const std::string& path, int priority, bool reload)
+{
+	//Replacing a queued creation still has to create
+	Upload* queued = find(texture);
+	reload = reload && (queued == NULL || queued->reload);
+	cancel(texture);
+
+	Upload* upload = new Upload;
+	upload->texture = texture;
+	upload->path = path;
+	upload->surface = surface;
+	SDL_AtomicSet(&upload->decoding.value, 0);
+	upload->priority = priority;
+	upload->drawn = false;
+	upload->reload = reload;
+	upload->sequence = mSequence++;
+	mQueue.push_back(upload);
+	texture->mQueued = true;
+}
+
+void LUploadScheduler::setPriority(LTexture* texture, int priority)
+{
+	Upload* upload = find(texture);
+	if (upload != NULL)
+	{
+		upload->priority = priority;
+	}
+}
+
+bool LUploadScheduler::isQueued(LTexture* texture)
+{
+	return find(texture) != NULL;
+}
+
+void LUploadScheduler::renderPlaceholder(SDL_Renderer* ren, LTexture* texture, const SDL_Rect* dst)
+{
+	Upload* upload = find(texture);
+	if (upload == NULL)
+	{
+		return;
+	}
+	upload->drawn = true;
+
+	if (!mPlaceholder)
+	{
+		SDL_Texture* placeholder = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, 1, 1);
+		if (placeholder == NULL)
+		{
+			return;
+		}
+		LMEMORY_TRACK_TEXTURE(placeholder, "upload placeholder");
+		Uint32 grey = 0xFF808080;
+		SDL_UpdateTexture(placeholder, NULL, &grey, sizeof(grey));
+		mPlaceholder.reset(placeholder);
+	}
+	renderCopy(ren, mPlaceholder.get(), NULL, dst);
+}
+
+bool LUploadScheduler::cancel(LTexture* texture)
+{
+	Upload* upload = find(texture);
+	if (upload == NULL)
+	{
+		return false;
+	}
+
+	//A decode in flight still writes into the entry, update() deletes it once done
+	upload->texture->mQueued = false;
+	upload->texture = NULL;
+	return true;
+}
+
+void LUploadScheduler::moved(LTexture* from, LTexture* to)
+{
+	Upload* upload = find(from);
+	if (upload != NULL)
+	{
+		upload->texture = to;
+	}
+}
+
+void LUploadScheduler::update(SDL_Renderer* ren)
+{
+	mFrameBytes = 0;
+	mFrameMs = 0.0;
+	if (mQueue.empty())
+	{
+		return;
+	}
+	LPROFILE_ZONE("LUploadScheduler::update");
+
+	//Cancelled entries go as soon as nothing writes into them
+	for (size_t i = 0; i < mQueue.size();)
+	{
+		Upload* upload = mQueue[i];
+		if (upload->texture == NULL && SDL_AtomicGet(&upload->decoding.value) == 0)
+		{
+			SDL_FreeSurface(upload->surface);
+			delete upload;
+			mQueue.erase(mQueue.begin() + i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	Uint64 start = SDL_GetPerformanceCounter();
+	Uint64 budgetTicks = mBudgetMicroseconds * SDL_GetPerformanceFrequency() / 1000000;
+	for (int index = next(); index >= 0; index = next())
+	{
+		//An image that would go over the byte budget waits, unless nothing has been uploaded yet this frame
+		Upload* upload = mQueue[index];
+		size_t bytes = upload->surface != NULL ? (size_t)upload->surface->w * upload->surface->h * 4 : 0;
+		if (mBudgetBytes > 0 && mFrameBytes > 0 && mFrameBytes + bytes > mBudgetBytes)
+		{
+			break;
+		}
+
+		//Taken out first, loading into the texture frees whatever it had queued
+		mQueue.erase(mQueue.begin() + index);
+
+		LTexture* texture = upload->texture;
+		texture->mQueued = false;
+		if (upload->surface == NULL)
+		{
+			//The decode error was set on the worker thread
+			printf("Unable to load image %s!\n", upload->path.c_str());
+			texture->free();
+		}
+		else
+		{
+			if (upload->reload)
+			{
+				texture->reloadFromSurface(ren, upload->surface, upload->path);
+			}
+			else
+			{
+				texture->loadFromSurface(ren, upload->surface, upload->path);
+			}
+			mFrameBytes += bytes;
+			SDL_FreeSurface(upload->surface);
+		}
+		delete upload;
+
+		//Whatever did not fit waits for the next frame
+		Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+		if ((mBudgetBytes > 0 && mFrameBytes >= mBudgetBytes) || (budgetTicks > 0 && elapsed >= budgetTicks))
+		{
+			break;
+		}
+	}
+	mFrameMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void LUploadScheduler::flush(SDL_Renderer* ren)
+{
+	for (size_t i = 0; i < mQueue.size(); ++i)
+	{
+		gJobSystem.wait(&mQueue[i]->decoding);
+	}
+
+	//No budget, so update() takes everything decoded
+	size_t bytes = mBudgetBytes;
+	Uint32 microseconds = mBudgetMicroseconds;
+	mBudgetBytes = 0;
+	mBudgetMicroseconds = 0;
+	update(ren);
+	mBudgetBytes = bytes;
+	mBudgetMicroseconds = microseconds;
+}
+
+void LUploadScheduler::clear()
+{
+	for (size_t i = 0; i < mQueue.size(); ++i)
+	{
+		if (mQueue[i]->texture != NULL)
+		{
+			mQueue[i]->texture->mQueued = false;
+		}
+		gJobSystem.wait(&mQueue[i]->decoding);
+		SDL_FreeSurface(mQueue[i]->surface);
+		delete mQueue[i];
+	}
+	mQueue.clear();
+	mPlaceholder.reset();
+}
+
+int LUploadScheduler::getPendingCount()
+{
+	int count = 0;
+	for (size_t i = 0; i < mQueue.size(); ++i)
+	{
+		if (mQueue[i]->texture != NULL)
+		{
+			++count;
+		}
+	}
+	return count;
+}
+
+size_t LUploadScheduler::getFrameBytes()
+{
+	return mFrameBytes;
+}
+
+double LUploadScheduler::getFrameMs()
+{
+	return mFrameMs;
+}
+
+void LUploadScheduler::decodeJob(void* data)
+{
+	Upload* upload = (Upload*)data;
+	upload->surface = gAssetArchive.loadImage(upload->path);
+}
+
+LUploadScheduler::Upload* LUploadScheduler::find(LTexture* texture)
+{
+	for (size_t i = 0; i < mQueue.size(); ++i)
+	{
+		if (mQueue[i]->texture == texture)
+		{
+			return mQueue[i];
+		}
+	}
+	return NULL;
+}
+
+int LUploadScheduler::next()
+{
+	//Priority, then drawn over not drawn, then oldest
+	int best = -1;
+	for (size_t i = 0; i < mQueue.size(); ++i)
+	{
+		Upload* upload = mQueue[i];
+		if (upload->texture == NULL || SDL_AtomicGet(&upload->decoding.value) != 0)
+		{
+			continue;
+		}
+		if (best >= 0)
+		{
+			const Upload* other = mQueue[best];
+			if (upload->priority != other->priority ? upload->priority < other->priority :
+				upload->drawn != other->drawn ? !upload->drawn : upload->sequence > other->sequence)
+			{
+				continue;
+			}
+		}
+		best = (int)i;
+	}
+	return best;
+}
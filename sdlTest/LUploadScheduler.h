@@ -0,0 +1,113 @@
+#pragma once
+
+#ifndef LUPLOADSCHEDULER_H
+#define LUPLOADSCHEDULER_H
+
+#include <string>
+#include <vector>
+#include "SDL.h"
+#include "LHandle.h"
+#include "LJobSystem.h"
+
+class LTexture;
+
+//Spreads texture creation and updates over frames so a scene switch does not upload everything at once
+//Images decode on the job system, update() then uploads finished ones until the frame budget is spent
+//Textures still waiting draw a flat placeholder the size of the image
+class LUploadScheduler
+{
+public:
+	//Budget used by --upload-budget
+	static const size_t DEFAULT_BYTES = 4 * 1024 * 1024;
+	static const Uint32 DEFAULT_MICROSECONDS = 4000;
+
+	//Initializes variables
+	LUploadScheduler();
+
+	//Frees queued surfaces
+	~LUploadScheduler();
+
+	//Per frame limits, zero for no limit, both zero turns scheduling off and uploads happen immediately
+	void setBudget(size_t bytes, Uint32 microseconds);
+	bool isEnabled();
+
+	//Decodes path on a job, then uploads it into texture
+	void load(LTexture* texture, const std::string& path, int priority);
+
+	//Takes over an already decoded surface, reload updates the existing texture instead of creating one
+	//A texture has at most one upload queued, a newer one replaces the older
+	void upload(LTexture* texture, SDL_Surface* surface, const std::string& path, int priority, bool reload);
+
+	//Changes the priority of a queued upload, higher goes first
+	void setPriority(LTexture* texture, int priority);
+
+	//Whether texture waits for a decode or an upload
+	bool isQueued(LTexture* texture);
+
+	//Draws the placeholder for a queued texture, drawn textures go ahead of others of the same priority
+	void renderPlaceholder(SDL_Renderer* ren, LTexture* texture, const SDL_Rect* dst);
+
+	//Drops the upload queued for texture, true if there was one
+	bool cancel(LTexture* texture);
+
+	//Points the upload of a moved texture at its new home
+	void moved(LTexture* from, LTexture* to);
+
+	//Uploads decoded images, highest priority first, while they fit in the frame budget
+	//At least one upload runs per frame so large images still get through
+	void update(SDL_Renderer* ren);
+
+	//Waits for every decode and uploads everything queued, ignoring the budget
+	//For when update() stops running, such as before the render thread takes the renderer
+	void flush(SDL_Renderer* ren);
+
+	//Waits for decodes in flight and frees everything queued and the placeholder
+	void clear();
+
+	//Uploads not done yet, decoding or decoded
+	int getPendingCount();
+
+	//Bytes and time the last update() spent
+	size_t getFrameBytes();
+	double getFrameMs();
+
+private:
+	struct Upload
+	{
+		//NULL once cancelled, the entry then only waits for its decode to finish
+		LTexture* texture;
+		std::string path;
+
+		//Set by the decode job, read once decoding reaches zero
+		SDL_Surface* surface;
+		LJobCounter decoding;
+
+		int priority;
+		bool drawn;
+		bool reload;
+		Uint32 sequence;
+	};
+
+	static void decodeJob(void* data);
+
+	//Queued entry of texture, NULL if it has none
+	Upload* find(LTexture* texture);
+
+	//Decoded entry to upload next, -1 if none is ready
+	int next();
+
+	//Main thread only
+	std::vector<Upload*> mQueue;
+	Uint32 mSequence;
+
+	size_t mBudgetBytes;
+	Uint32 mBudgetMicroseconds;
+	size_t mFrameBytes;
+	double mFrameMs;
+
+	//Flat grey, stretched over the image rectangle
+	LTextureHandle mPlaceholder;
+};
+
+extern LUploadScheduler gUploadScheduler;
+#endif
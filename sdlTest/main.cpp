@@ -1,70 +1,36 @@
 // Example program:
 // Using SDL2 to create an application window
 
-#ifndef CLEANUP_H
-#define CLEANUP_H
-
-#include <utility>
-#include <SDL.h>
-
-/*
- * Recurse through the list of arguments to clean up, cleaning up
- * the first one in the list each iteration.
- */
-template<typename T, typename... Args>
-void cleanup(T* t, Args&& ... args) {
-	//Cleanup the first item in the list
-	cleanup(t);
-	//Recurse to clean up the remaining arguments
-	cleanup(std::forward<Args>(args)...);
-}
-
-/*
- * These specializations serve to free the passed argument and also provide the
- * base cases for the recursive call above, eg. when args is only a single item
- * one of the specializations below will be called by
- * cleanup(std::forward<Args>(args)...), ending the recursion
- * We also make it safe to pass nullptrs to handle situations where we
- * don't want to bother finding out which values failed to load (and thus are null)
- * but rather just want to clean everything up and let cleanup sort it out
- */
-template<>
-inline void cleanup<SDL_Window>(SDL_Window* win) {
-	if (!win) {
-		return;
-	}
-	SDL_DestroyWindow(win);
-}
-template<>
-inline void cleanup<SDL_Renderer>(SDL_Renderer* ren) {
-	if (!ren) {
-		return;
-	}
-	SDL_DestroyRenderer(ren);
-}
-template<>
-inline void cleanup<SDL_Texture>(SDL_Texture* tex) {
-	if (!tex) {
-		return;
-	}
-	SDL_DestroyTexture(tex);
-}
-template<>
-inline void cleanup<SDL_Surface>(SDL_Surface* surf) {
-	if (!surf) {
-		return;
-	}
-	SDL_FreeSurface(surf);
-}
-
-#endif
-
 #include "SDL.h"
 #include <stdio.h>
 #include <iostream>
+#include <vector>
+#include <utility>
 #include "SDL_image.h"
 #include "SDL_ttf.h"
 #include"LTexture.h"
+#include"LHandle.h"
+#include"LFrameCapture.h"
+#include"LCommandList.h"
+#include"LParticleSystem.h"
+#include"LAnimation.h"
+#include"LScaledCache.h"
+#include"LRenderState.h"
+#include"LFrameArena.h"
+#include"LSurfacePool.h"
+#include"LMemoryTracker.h"
+#include"LProfiler.h"
+#include"LRenderStats.h"
+#include"LHud.h"
+#include"LStartupTrace.h"
+#include"LAssetPreloader.h"
+#include"LJobSystem.h"
+#include"LRenderThread.h"
+#include"LAssetArchive.h"
+#include"LAssetWatcher.h"
+#include"LUploadScheduler.h"
+#include"LBitmap.h"
+#include"LTiledImage.h"
 
 //#pragma comment(lib ,"SDL2.lib")
 //#pragma comment(lib ,"SDL2main.lib")
@@ -94,11 +60,13 @@ void logIMGError(const std::string& msg) {
 
 SDL_Texture* lazyFoo_loadTexture(std::string path, SDL_Renderer* ren)
 {
+	LSTARTUP_PHASE(path.c_str());
+
 	//The final texture
 	SDL_Texture* newTexture = NULL;
 
 	//Load image at specified path
-	SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+	SDL_Surface* loadedSurface = gAssetArchive.loadImage(path);
 	if (loadedSurface == NULL)
 	{
 		printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
@@ -111,6 +79,7 @@ SDL_Texture* lazyFoo_loadTexture(std::string path, SDL_Renderer* ren)
 		{
 			printf("Unable to create texture from %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
 		}
+		LMEMORY_TRACK_TEXTURE(newTexture, path.c_str());
 
 		//Get rid of old loaded surface
 		SDL_FreeSurface(loadedSurface);
@@ -120,15 +89,17 @@ SDL_Texture* lazyFoo_loadTexture(std::string path, SDL_Renderer* ren)
 }
 
 SDL_Texture* loadTexture(const std::string& file, SDL_Renderer* ren) {
+	LSTARTUP_PHASE(file.c_str());
 	SDL_Texture* texture = IMG_LoadTexture(ren, file.c_str());
 	if (texture == nullptr) {
 		logSDLError("loadTexture");
 	}
+	LMEMORY_TRACK_TEXTURE(texture, file.c_str());
 	return texture;
 }
 void renderTexture(SDL_Texture* tex, SDL_Renderer* ren, SDL_Rect dst, SDL_Rect* clip = nullptr)
 {
-	SDL_RenderCopy(ren, tex, clip, &dst);
+	renderCopy(ren, tex, clip, &dst);
 }
 void renderTexture(SDL_Texture* tex, SDL_Renderer* ren, int x, int y, SDL_Rect* clip = nullptr)
 {
@@ -142,7 +113,7 @@ void renderTexture(SDL_Texture* tex, SDL_Renderer* ren, int x, int y, SDL_Rect*
 	else {
 		SDL_QueryTexture(tex, NULL, NULL, &dst.w, &dst.h);
 	}
-	SDL_RenderCopy(ren, tex, clip, &dst);
+	renderCopy(ren, tex, clip, &dst);
 }
 void renderTexture(SDL_Texture* tex, SDL_Renderer* ren, int x, int y, int w, int h) {
 	SDL_Rect dst;
@@ -150,40 +121,60 @@ void renderTexture(SDL_Texture* tex, SDL_Renderer* ren, int x, int y, int w, int
 	dst.y = y;
 	dst.w = w;
 	dst.h = h;
-	SDL_RenderCopy(ren, tex, NULL, &dst);
+	renderCopy(ren, tex, NULL, &dst);
 }
 
-SDL_Texture* renderText(const std::string& message, const std::string& fontFile,
+SDL_Texture* renderText(const char* message, const char* fontFile,
 	SDL_Color color, int fontSize, SDL_Renderer* renderer)
 {
-	TTF_Font* font = TTF_OpenFont(fontFile.c_str(), fontSize);
-	if (font == nullptr) {
+	LPROFILE_ZONE("renderText");
+	LSTARTUP_PHASE(fontFile);
+
+	LFontHandle font(TTF_OpenFontRW(gAssetArchive.openFile(fontFile), 1, fontSize));
+	if (!font) {
 		logSDLError(std::cout, "TTF_OpenFont");
 		return nullptr;
 	}
-	SDL_Surface* surf = TTF_RenderText_Blended(font, message.c_str(), color);
-	if (surf == nullptr) {
-		TTF_CloseFont(font);
+	//FreeType streams glyphs from the file, its resident size is not exposed
+	LMEMORY_TRACK_FONT(font.get(), fontFile, 0);
+	LSurfaceHandle surf(TTF_RenderText_Blended(font.get(), message, color));
+	if (!surf) {
 		logSDLError(std::cout, "TTF_RenderText");
 		return nullptr;
 	}
-	SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surf);
+	SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surf.get());
 	if (texture == nullptr) {
 		logSDLError(std::cout, "CreateTexture");
 	}
-	SDL_FreeSurface(surf);
-	TTF_CloseFont(font);
+	LMEMORY_TRACK_TEXTURE(texture, message);
 	return texture;
 }
 
-SDL_Window* gWindow = NULL;
-SDL_Renderer* gRenderer = NULL;
+SDL_Texture* renderText(const std::string& message, const std::string& fontFile,
+	SDL_Color color, int fontSize, SDL_Renderer* renderer)
+{
+	return renderText(message.c_str(), fontFile.c_str(), color, fontSize, renderer);
+}
+
+LWindowHandle gWindow;
+LRendererHandle gRenderer;
+//Drops redundant state changes on gRenderer
+LRenderState gRenderState;
+//Transient per frame data, recycled in presentFrame()
+LFrameArena gFrameArena;
+//Performance overlay, toggled with H
+LHud gHud;
+
+//Performance counter of the first input not yet on screen, 0 for none
+Uint64 gInputTime = 0;
+//Latency of frames presented by presentFrame()
+LLatencyStats gSerialLatency;
 //The surface contained by the window
 SDL_Surface* gScreenSurface = NULL;
 
 
 //Current displayed texture
-SDL_Texture* gTexture = NULL;
+LTextureHandle gTexture;
 
 //Scene textures
 LTexture gFooTexture;
@@ -192,16 +183,36 @@ LTexture gBackgroundTexture;
 //Scene sprites
 SDL_Rect gSpriteClips[4];
 LTexture gSpriteSheetTexture;
+LAnimationSet gDotAnimations;
 
 LTexture gModulatedTexture;
 
+//Stretched background and its resampled copies
+LBitmap gStretchBitmap;
+LScaledCache gScaledCache;
+
+//Tiled large image, toggled with 3, built by sdlTiles
+LTiledImage gTiledImage;
+std::string gTiledPath = "big.til";
+//Image pixel at the top left of the window and screen pixels per image pixel, 0 until first shown
+double gTiledX = 0.0;
+double gTiledY = 0.0;
+double gTiledZoom = 0.0;
+
+//Gameplay recorder, toggled with C
+LFrameCapture gFrameCapture;
+
+//Loads an image converted to the screen format into a pooled surface
+//Return the surface with gSurfacePool.release()
 SDL_Surface* loadSurface(std::string path)
 {
+	LSTARTUP_PHASE(path.c_str());
+
 	//The final optimized image
 	SDL_Surface* optimizedSurface = NULL;
 
 	//Load image at specified path
-	SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+	SDL_Surface* loadedSurface = gAssetArchive.loadImage(path);
 	if (loadedSurface == NULL)
 	{
 		//Unable to load image
@@ -210,7 +221,8 @@ SDL_Surface* loadSurface(std::string path)
 	else
 	{
 		//Convert surface to screen format
-		optimizedSurface = SDL_ConvertSurface(loadedSurface, gScreenSurface->format, 0);
+		Uint32 screenFormat = gScreenSurface != NULL ? gScreenSurface->format->format : SDL_GetWindowPixelFormat(gWindow.get());
+		optimizedSurface = gSurfacePool.convert(loadedSurface, screenFormat);
 		if (optimizedSurface == NULL)
 		{
 			logSDLError("SDL_ConvertSurface");
@@ -223,40 +235,84 @@ SDL_Surface* loadSurface(std::string path)
 
 	return optimizedSurface;
 }
+bool loadMedia9() {
+	LSTARTUP_PHASE("loadMedia9");
+
+	//Loading success flag
+	bool success = true;
+
+	gTexture.reset(loadTexture("res/lession9_viewport.png", gRenderer.get()));
+	if (!gTexture) {
+		printf("Failed to load viewport texture!\n");
+		success = false;
+	}
+
+	return success;
+}
+
+bool loadMedia10() {
+	LSTARTUP_PHASE("loadMedia10");
+
+	//Loading success flag
+	bool success = true;
+
+	if (!gFooTexture.loadFromFile(gRenderer.get(), "res/lession10/foo.png")) {
+		printf("Failed to load Foo' texture image!\n");
+		success = false;
+	}
+	if (!gBackgroundTexture.loadFromFile(gRenderer.get(), "res/lession10/background.png")) {
+		printf("Failed to load background texture image!\n");
+		success = false;
+	}
+
+	return success;
+}
+
 bool loadMedia11() {
+	LSTARTUP_PHASE("loadMedia11");
+
 	//Loading success flag
 	bool success = true;
 
 
 
-	if (!gSpriteSheetTexture.loadFromFile(gRenderer, "res/dots.png")) {
+	if (!gSpriteSheetTexture.loadFromFile(gRenderer.get(), "res/dots.png")) {
 		printf("Failed to load sprite sheet texture!\n");
 		success = false;
 	}
+	else if (!gDotAnimations.loadFromFile("res/dots.anim")) {
+		printf("Failed to load sprite animations!\n");
+		success = false;
+	}
 	else {
-		//Set top left sprite
-		gSpriteClips[0].x = 0;
-		gSpriteClips[0].y = 0;
-		gSpriteClips[0].w = 100;
-		gSpriteClips[0].h = 100;
-
-		//Set top right sprite
-		gSpriteClips[1].x = 100;
-		gSpriteClips[1].y = 0;
-		gSpriteClips[1].w = 100;
-		gSpriteClips[1].h = 100;
-
-		//Set bottom left sprite
-		gSpriteClips[2].x = 0;
-		gSpriteClips[2].y = 100;
-		gSpriteClips[2].w = 100;
-		gSpriteClips[2].h = 100;
-
-		//Set bottom right sprite
-		gSpriteClips[3].x = 100;
-		gSpriteClips[3].y = 100;
-		gSpriteClips[3].w = 100;
-		gSpriteClips[3].h = 100;
+		//Corner sprites are the frames of the dots sequence
+		int dots = gDotAnimations.find("dots");
+		if (dots < 0 || gDotAnimations.getFrameCount(dots) < 4) {
+			printf("Sprite animations have no 4 frame dots sequence!\n");
+			success = false;
+		}
+		else {
+			for (int i = 0; i < 4; ++i) {
+				gSpriteClips[i] = gDotAnimations.getClips()[gDotAnimations.getFirstClip(dots) + i];
+			}
+		}
+	}
+
+	return success;
+}
+
+bool loadMediaStretch() {
+	LSTARTUP_PHASE("loadMediaStretch");
+
+	//Loading success flag
+	bool success = true;
+
+	if (!gStretchBitmap.loadFromFile("stretch.bmp")) {
+		success = false;
+	}
+	else if (!gStretchBitmap.isMapped()) {
+		//Mapped pixels belong to the page cache, not the heap
+		LMEMORY_TRACK_SURFACE(gStretchBitmap.getSurface(), "stretch.bmp");
 	}
 
 	return success;
@@ -264,14 +320,19 @@ bool loadMedia11() {
 
 bool loadMedia()
 {
+	LSTARTUP_PHASE("loadMedia");
+
 	//Loading success flag
 	bool success = true;
 
 
-	if (!gModulatedTexture.loadFromFile(gRenderer, "res/full.png")) {
+	if (!gAssetPreloader.loadTexture(gModulatedTexture, gRenderer.get(), "res/full.png")) {
 		printf("Failed to load texture!\n");
 		success = false;
 	}
+
+	//The first frame draws it, so its decode starts now
+	gModulatedTexture.prefetch();
 	
 	return success;
 }
@@ -289,101 +350,207 @@ SDL_Renderer* InitRender(SDL_Window* window) {
 
 bool init()
 {
+	LSTARTUP_PHASE("init");
+
 	//Initialization flag
 	bool success = true;
 
 	//Initialize SDL
-	if (SDL_Init(SDL_INIT_VIDEO) < 0)
 	{
-		logSDLError("SDL_Init");
-		return false;
+		LSTARTUP_PHASE("SDL_Init");
+		if (SDL_Init(SDL_INIT_VIDEO) < 0)
+		{
+			logSDLError("SDL_Init");
+			return false;
+		}
 	}
-	if (TTF_Init() != 0) {
-		logSDLError(std::cout, "TTF_Init");
-		return false;
+	{
+		LSTARTUP_PHASE("TTF_Init");
+		if (TTF_Init() != 0) {
+			logSDLError(std::cout, "TTF_Init");
+			return false;
+		}
 	}
 	//Set texture filtering to linear
-	if (!SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1"))
 	{
-		printf("Warning: Linear texture filtering not enabled!");
+		LSTARTUP_PHASE("SDL_SetHint");
+		if (!SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1"))
+		{
+			printf("Warning: Linear texture filtering not enabled!");
+		}
 	}
 
 	//Create window
-	gWindow = SDL_CreateWindow("SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
-	if (gWindow == NULL)
 	{
-		logSDLError("SDL_CreateWindow");
-		return false;
+		LSTARTUP_PHASE("SDL_CreateWindow");
+		gWindow.reset(SDL_CreateWindow("SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN));
+		if (!gWindow)
+		{
+			logSDLError("SDL_CreateWindow");
+			return false;
+		}
 	}
 
-	gRenderer = InitRender(gWindow);
-	SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+	{
+		LSTARTUP_PHASE("InitRender");
+		gRenderer.reset(InitRender(gWindow.get()));
+		gRenderState.attach(gRenderer.get());
+		gRenderState.setDrawColor(0xFF, 0xFF, 0xFF, 0xFF);
+		gFrameArena.reserve(64 * 1024);
+	}
 
 	//Initialize PNG loading
-	int imgFlags = IMG_INIT_PNG;
-	if (!(IMG_Init(imgFlags) & imgFlags))
 	{
-		logIMGError("IMG_Init");
-		return false;
+		LSTARTUP_PHASE("IMG_Init");
+		int imgFlags = IMG_INIT_PNG;
+		if (!(IMG_Init(imgFlags) & imgFlags))
+		{
+			logIMGError("IMG_Init");
+			return false;
+		}
 	}
 	return success;
 }
 
+//Startup with asset decoding overlapped with window and renderer creation
+bool initParallel()
+{
+	LSTARTUP_PHASE("initParallel");
+
+	//Decoders are set up before any worker uses them
+	{
+		LSTARTUP_PHASE("IMG_Init");
+		int imgFlags = IMG_INIT_PNG;
+		if (!(IMG_Init(imgFlags) & imgFlags))
+		{
+			logIMGError("IMG_Init");
+			return false;
+		}
+	}
+
+	//Everything the first frames need
+	{
+		LSTARTUP_PHASE("start preload");
+		if (!LTexture::isLazy()) {
+			gAssetPreloader.addImage("res/full.png");
+		}
+		gAssetPreloader.addFile("sample.ttf");
+		gAssetPreloader.start();
+	}
+
+	//Uploads wait for their decode once the renderer exists
+	return init() && loadMedia();
+}
+
+void presentFrame()
+{
+	//Uploads and other SDL work queued by jobs
+	gJobSystem.pumpMainThread();
+
+	//Texture uploads that fit this frame's budget
+	gUploadScheduler.update(gRenderer.get());
+
+	//Images changed on disk, only those already decoded
+	gAssetWatcher.update(gRenderer.get());
+
+	//Overlay goes on top of the scene, and into any recording
+	gHud.render(gRenderer.get());
+
+	//Grab the finished frame before it is flipped away
+	gFrameCapture.captureFrame(gRenderer.get());
+
+	//Update screen
+	{
+		LPROFILE_ZONE("SDL_RenderPresent");
+		SDL_RenderPresent(gRenderer.get());
+	}
+	gSerialLatency.record(gInputTime, SDL_GetPerformanceCounter());
+	gInputTime = 0;
+	gStartupTrace.presented();
+	gRenderStats.endFrame();
+	gRenderState.endFrame();
+	gFrameArena.endFrame();
+
+	LHudStats stats;
+	stats.drawCalls = gRenderStats.getDrawCalls();
+	stats.textureSwitches = gRenderStats.getTextureSwitches();
+	stats.stateChanges = gRenderState.getIssuedCalls();
+	stats.elidedStateChanges = gRenderState.getElidedCalls();
+	stats.textureBytes = gMemoryTracker.getBytes(LMemoryTracker::TEXTURE);
+	gHud.endFrame(stats);
+#ifdef _DEBUG
+	//Steady state frames must not touch the heap for transient data
+	if (gFrameArena.getFrameMallocs() > 0)
+	{
+		printf("Frame arena grew: %u heap allocations, high water %u bytes\n",
+			gFrameArena.getFrameMallocs(), (unsigned)gFrameArena.getHighWater());
+	}
+#endif
+	LPROFILE_FRAME();
+}
+
 void DrawLession8()
 {
+	LPROFILE_ZONE("DrawLession8");
+
 	//Clear screen
-	SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
-	SDL_RenderClear(gRenderer);
+	gRenderState.setDrawColor(0xFF, 0xFF, 0xFF, 0xFF);
+	renderClear(gRenderer.get());
 
 	//Render red filled quad
 	SDL_Rect fillRect = { SCREEN_WIDTH / 4, SCREEN_HEIGHT / 4, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 };
-	SDL_SetRenderDrawColor(gRenderer, 0xFF, 0x00, 0x00, 0xFF);
-	SDL_RenderFillRect(gRenderer, &fillRect);
+	gRenderState.setDrawColor(0xFF, 0x00, 0x00, 0xFF);
+	renderFillRect(gRenderer.get(), &fillRect);
 
 	//Render green outlined quad
 	SDL_Rect outlineRect = { SCREEN_WIDTH / 6, SCREEN_HEIGHT / 6, SCREEN_WIDTH * 2 / 3, SCREEN_HEIGHT * 2 / 3 };
-	SDL_SetRenderDrawColor(gRenderer, 0x00, 0xFF, 0x00, 0xFF);
-	SDL_RenderDrawRect(gRenderer, &outlineRect);
+	gRenderState.setDrawColor(0x00, 0xFF, 0x00, 0xFF);
+	renderDrawRect(gRenderer.get(), &outlineRect);
 
 	//Draw blue horizontal line
-	SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0xFF, 0xFF);
-	SDL_RenderDrawLine(gRenderer, 0, SCREEN_HEIGHT / 2, SCREEN_WIDTH, SCREEN_HEIGHT / 2);
+	gRenderState.setDrawColor(0x00, 0x00, 0xFF, 0xFF);
+	renderDrawLine(gRenderer.get(), 0, SCREEN_HEIGHT / 2, SCREEN_WIDTH, SCREEN_HEIGHT / 2);
 
 	//Draw vertical line of yellow dots
-	SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0x00, 0xFF);
+	gRenderState.setDrawColor(0xFF, 0xFF, 0x00, 0xFF);
+	LFrameVector<SDL_Point> dots((LFrameAllocator<SDL_Point>(gFrameArena)));
+	dots.reserve(SCREEN_HEIGHT / 4);
 	for (int i = 0; i < SCREEN_HEIGHT; i += 4)
 	{
-		SDL_RenderDrawPoint(gRenderer, SCREEN_WIDTH / 2, i);
+		SDL_Point dot = { SCREEN_WIDTH / 2, i };
+		dots.push_back(dot);
 	}
+	renderDrawPoints(gRenderer.get(), &dots[0], (int)dots.size());
 
 
-	//Update screen
-	SDL_RenderPresent(gRenderer);
+	presentFrame();
 }
 
-void DrawViewPort(SDL_Renderer* render, int x, int y, int w, int h)
+void DrawViewPort(int x, int y, int w, int h)
 {
 	SDL_Rect rect;
 	rect.x = x;
 	rect.y = y;
 	rect.w = w;
 	rect.h = h;
-	SDL_RenderSetViewport(render, &rect);
+	gRenderState.setViewport(&rect);
 }
 
 void DrawLession9()
 {
+	LPROFILE_ZONE("DrawLession9");
+
 	//Top left corner viewport
-	DrawViewPort(gRenderer, 0, 0, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+	DrawViewPort(0, 0, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
 
 	//Render texture to screen
-	SDL_RenderCopy(gRenderer, gTexture, NULL, NULL);
+	renderCopy(gRenderer.get(), gTexture.get(), NULL, NULL);
 
 	//Top right viewport
-	DrawViewPort(gRenderer, SCREEN_WIDTH / 2, 0, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+	DrawViewPort(SCREEN_WIDTH / 2, 0, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
 
 	//Render texture to screen
-	SDL_RenderCopy(gRenderer, gTexture, NULL, NULL);
+	renderCopy(gRenderer.get(), gTexture.get(), NULL, NULL);
 
 	//Bottom viewport
 	SDL_Rect bottomViewport;
@@ -391,75 +558,689 @@ void DrawLession9()
 	bottomViewport.y = SCREEN_HEIGHT / 2;
 	bottomViewport.w = SCREEN_WIDTH;
 	bottomViewport.h = SCREEN_HEIGHT / 2;
-	DrawViewPort(gRenderer, 0, SCREEN_HEIGHT / 2, SCREEN_WIDTH, SCREEN_HEIGHT / 2);
+	DrawViewPort(0, SCREEN_HEIGHT / 2, SCREEN_WIDTH, SCREEN_HEIGHT / 2);
 
 	//Render texture to screen
-	SDL_RenderCopy(gRenderer, gTexture, NULL, NULL);
+	renderCopy(gRenderer.get(), gTexture.get(), NULL, NULL);
 
 
 	//Update screen
-	SDL_RenderPresent(gRenderer);
+	presentFrame();
 }
 
 void DrawLession10() {
+	LPROFILE_ZONE("DrawLession10");
+
 	//Clear screen
-	SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
-	SDL_RenderClear(gRenderer);
+	gRenderState.setDrawColor(0xFF, 0xFF, 0xFF, 0xFF);
+	renderClear(gRenderer.get());
 
 	//Render background texture to screen
-	gBackgroundTexture.render(gRenderer, 0, 0);
+	gBackgroundTexture.render(gRenderer.get(), 0, 0);
 
 	//Render Foo' to the screen
-	gFooTexture.render(gRenderer, 240, 190);
+	gFooTexture.render(gRenderer.get(), 240, 190);
 
 	//Update screen
-	SDL_RenderPresent(gRenderer);
+	presentFrame();
 }
 
 void DrawLession11() {
+	LPROFILE_ZONE("DrawLession11");
+
 	//Clear screen
-	SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
-	SDL_RenderClear(gRenderer);
+	gRenderState.setDrawColor(0xFF, 0xFF, 0xFF, 0xFF);
+	renderClear(gRenderer.get());
 
 	//Render top left sprite
-	gSpriteSheetTexture.render(gRenderer, 0, 0, &gSpriteClips[0]);
+	gSpriteSheetTexture.render(gRenderer.get(), 0, 0, &gSpriteClips[0]);
 
 	//Render top right sprite
-	gSpriteSheetTexture.render(gRenderer, SCREEN_WIDTH - gSpriteClips[1].w, 0, &gSpriteClips[1]);
+	gSpriteSheetTexture.render(gRenderer.get(), SCREEN_WIDTH - gSpriteClips[1].w, 0, &gSpriteClips[1]);
 
 	//Render bottom left sprite
-	gSpriteSheetTexture.render(gRenderer, 0, SCREEN_HEIGHT - gSpriteClips[2].h, &gSpriteClips[2]);
+	gSpriteSheetTexture.render(gRenderer.get(), 0, SCREEN_HEIGHT - gSpriteClips[2].h, &gSpriteClips[2]);
 
 	//Render bottom right sprite
-	gSpriteSheetTexture.render(gRenderer, SCREEN_WIDTH - gSpriteClips[3].w, SCREEN_HEIGHT - gSpriteClips[3].h, &gSpriteClips[3]);
+	gSpriteSheetTexture.render(gRenderer.get(), SCREEN_WIDTH - gSpriteClips[3].w, SCREEN_HEIGHT - gSpriteClips[3].h, &gSpriteClips[3]);
 
 	//Update screen
-	SDL_RenderPresent(gRenderer);
+	presentFrame();
 }
 
 void DrawLession12(SDL_Renderer* render, Uint8 r , Uint8 g, Uint8 b) {
+	LPROFILE_ZONE("DrawLession12");
+
 	//Clear screen
-	SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
-	SDL_RenderClear(gRenderer);
+	gRenderState.setDrawColor(0xFF, 0xFF, 0xFF, 0xFF);
+	renderClear(gRenderer.get());
 
 	//Modulate and render texture
-	gModulatedTexture.setColor(r, g, b);
+	gRenderState.setTextureColorMod(gModulatedTexture.getTexture(), r, g, b);
 	gModulatedTexture.render(render,0, 0);
 
 	//Update screen
-	SDL_RenderPresent(gRenderer);
+	presentFrame();
+}
+
+//Hands the renderer to the render thread, which submits and presents recorded frames
+bool startRenderThread() {
+	//Lazy textures the recorded frames draw are loaded here, record code must not create textures
+	gModulatedTexture.getTexture();
+
+	//Queued uploads would never land, update() only runs in presentFrame()
+	gUploadScheduler.flush(gRenderer.get());
+	return gRenderThread.start(gRenderer.get(), gWindow.get());
+}
+
+void stopRenderThread() {
+	if (gRenderThread.isRunning())
+	{
+		gRenderThread.stop();
+
+		//The render thread changed state behind the cache's back
+		gRenderState.invalidate();
+	}
+}
+
+//Same frame as DrawLession12, recorded for the render thread
+void recordLession12(LCommandList& list, Uint8 r, Uint8 g, Uint8 b) {
+	LPROFILE_ZONE("recordLession12");
+
+	list.setDrawColor(0xFF, 0xFF, 0xFF, 0xFF);
+	list.clearTarget();
+
+	//Loaded by startRenderThread(), nothing to draw if that failed
+	if (!gModulatedTexture.isLoaded())
+	{
+		return;
+	}
+	SDL_Texture* texture = gModulatedTexture.getTexture();
+	SDL_Rect dst = { 0, 0, gModulatedTexture.getWidth(), gModulatedTexture.getHeight() };
+	list.setColorMod(texture, r, g, b);
+	list.copy(texture, NULL, dst);
+}
+
+//Hands the frame to the render thread instead of presenting it here
+void submitLession12(Uint8 r, Uint8 g, Uint8 b) {
+	//Reloads need the renderer, so it comes back for one frame that applies them
+	if (gAssetWatcher.hasReloads())
+	{
+		stopRenderThread();
+		DrawLession12(gRenderer.get(), r, g, b);
+		startRenderThread();
+		return;
+	}
+
+	LCommandList& list = gRenderThread.beginFrame();
+	recordLession12(list, r, g, b);
+	gRenderThread.endFrame(gInputTime);
+	gInputTime = 0;
+
+	gFrameArena.endFrame();
+	LPROFILE_FRAME();
+}
+
+void DrawStretch() {
+	LPROFILE_ZONE("DrawStretch");
+
+	//Resample once per output size, then every frame is a plain copy
+	int w = 0;
+	int h = 0;
+	SDL_GetRendererOutputSize(gRenderer.get(), &w, &h);
+	SDL_Texture* stretched = gScaledCache.getTexture(gRenderer.get(), gStretchBitmap.getSurface(), w, h);
+
+	renderCopy(gRenderer.get(), stretched, NULL, NULL);
+
+	//Update screen
+	presentFrame();
+}
+
+void DrawTiles() {
+	LPROFILE_ZONE("DrawTiles");
+
+	int w = 0;
+	int h = 0;
+	SDL_GetRendererOutputSize(gRenderer.get(), &w, &h);
+
+	//Starts with the whole image in view
+	static Uint64 last = 0;
+	Uint64 now = SDL_GetPerformanceCounter();
+	double seconds = last == 0 ? 0.0 : SDL_min(0.1, (now - last) / (double)SDL_GetPerformanceFrequency());
+	last = now;
+	double fit = SDL_min((double)w / gTiledImage.getWidth(), (double)h / gTiledImage.getHeight());
+	if (gTiledZoom <= 0.0)
+	{
+		gTiledZoom = fit;
+		gTiledX = (gTiledImage.getWidth() - w / fit) * 0.5;
+		gTiledY = (gTiledImage.getHeight() - h / fit) * 0.5;
+	}
+
+	//Arrows pan, plus and minus zoom around the window centre
+	const Uint8* keys = SDL_GetKeyboardState(NULL);
+	double pan = 600.0 * seconds / gTiledZoom;
+	gTiledX += (keys[SDL_SCANCODE_RIGHT] - keys[SDL_SCANCODE_LEFT]) * pan;
+	gTiledY += (keys[SDL_SCANCODE_DOWN] - keys[SDL_SCANCODE_UP]) * pan;
+	int zoomIn = keys[SDL_SCANCODE_EQUALS] + keys[SDL_SCANCODE_KP_PLUS] - keys[SDL_SCANCODE_MINUS] - keys[SDL_SCANCODE_KP_MINUS];
+	if (zoomIn != 0)
+	{
+		double centerX = gTiledX + w * 0.5 / gTiledZoom;
+		double centerY = gTiledY + h * 0.5 / gTiledZoom;
+		gTiledZoom = SDL_max(fit * 0.5, SDL_min(8.0, gTiledZoom * SDL_pow(2.0, SDL_max(-1, SDL_min(1, zoomIn)) * seconds * 1.5)));
+		gTiledX = centerX - w * 0.5 / gTiledZoom;
+		gTiledY = centerY - h * 0.5 / gTiledZoom;
+	}
+
+	gRenderState.setDrawColor(0x00, 0x00, 0x00, 0xFF);
+	renderClear(gRenderer.get());
+	SDL_Rect dst = { 0, 0, w, h };
+	gTiledImage.render(gRenderer.get(), gTiledX, gTiledY, gTiledZoom, &dst);
+
+	//Update screen
+	presentFrame();
+}
+
+//Synthetic scene used to measure parallel command recording
+struct SceneObject
+{
+	float x;
+	float y;
+	float speed;
+	int clip;
+};
+
+struct SceneFrame
+{
+	const SceneObject* objects;
+	int objectCount;
+	float time;
+};
+
+void recordSceneSlice(LCommandList& list, int index, int count, void* userdata)
+{
+	const SceneFrame* frame = (const SceneFrame*)userdata;
+	int begin = (int)((Sint64)frame->objectCount * index / count);
+	int end = (int)((Sint64)frame->objectCount * (index + 1) / count);
+	SDL_Texture* texture = gSpriteSheetTexture.getTexture();
+
+	list.clear();
+	for (int i = begin; i < end; ++i)
+	{
+		//Animate and cull against the screen
+		const SceneObject& object = frame->objects[i];
+		const SDL_Rect& clip = gSpriteClips[object.clip];
+		int x = (int)(object.x + SDL_sinf(frame->time * object.speed) * 64.0f);
+		int y = (int)(object.y + SDL_cosf(frame->time * object.speed) * 64.0f);
+		if (x + clip.w < 0 || y + clip.h < 0 || x >= SCREEN_WIDTH || y >= SCREEN_HEIGHT)
+		{
+			continue;
+		}
+		SDL_Rect dst = { x, y, clip.w, clip.h };
+		list.copy(texture, &clip, dst);
+	}
+}
+
+void benchmarkCommandLists()
+{
+	if (gSpriteSheetTexture.getTexture() == NULL && !loadMedia11())
+	{
+		return;
+	}
+
+	//100k objects spread over a world 16 screens large
+	const int objectCount = 100000;
+	const int frames = 30;
+	std::vector<SceneObject> objects(objectCount);
+	Uint32 seed = 12345;
+	for (int i = 0; i < objectCount; ++i)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		objects[i].x = (float)((seed >> 8) % (SCREEN_WIDTH * 4)) - SCREEN_WIDTH * 1.5f;
+		seed = seed * 1664525u + 1013904223u;
+		objects[i].y = (float)((seed >> 8) % (SCREEN_HEIGHT * 4)) - SCREEN_HEIGHT * 1.5f;
+		objects[i].speed = 0.5f + (i % 7) * 0.25f;
+		objects[i].clip = i % 4;
+	}
+
+	int threadCount = SDL_GetCPUCount();
+	std::vector<LCommandList> lists(threadCount);
+	for (int i = 0; i < threadCount; ++i)
+	{
+		lists[i].reserve(objectCount / threadCount + 1);
+	}
+
+	double freq = (double)SDL_GetPerformanceFrequency();
+	Uint64 serialTicks = 0;
+	Uint64 parallelTicks = 0;
+	Uint64 submitTicks = 0;
+	size_t recorded = 0;
+	for (int f = 0; f < frames; ++f)
+	{
+		SceneFrame frame = { &objects[0], objectCount, f / 60.0f };
+
+		Uint64 start = SDL_GetPerformanceCounter();
+		LCommandList::recordParallel(&lists[0], 1, recordSceneSlice, &frame);
+		serialTicks += SDL_GetPerformanceCounter() - start;
+
+		start = SDL_GetPerformanceCounter();
+		LCommandList::recordParallel(&lists[0], threadCount, recordSceneSlice, &frame);
+		parallelTicks += SDL_GetPerformanceCounter() - start;
+
+		start = SDL_GetPerformanceCounter();
+		gRenderState.setDrawColor(0xFF, 0xFF, 0xFF, 0xFF);
+		renderClear(gRenderer.get());
+		LCommandList::submitAll(gRenderer.get(), &lists[0], threadCount);
+		gRenderState.invalidate();
+		presentFrame();
+		submitTicks += SDL_GetPerformanceCounter() - start;
+
+		recorded = 0;
+		for (int i = 0; i < threadCount; ++i)
+		{
+			recorded += lists[i].size();
+		}
+	}
+
+	double serialMs = serialTicks * 1000.0 / freq / frames;
+	double parallelMs = parallelTicks * 1000.0 / freq / frames;
+	printf("Command lists: %d objects, %u visible, record 1 thread %.3f ms, %d threads %.3f ms (%.2fx), submit %.3f ms\n",
+		objectCount, (unsigned)recorded, serialMs, threadCount, parallelMs, serialMs / parallelMs, submitTicks * 1000.0 / freq / frames);
+}
+
+void benchmarkParticles()
+{
+	if (gSpriteSheetTexture.getTexture() == NULL && !loadMedia11())
+	{
+		return;
+	}
+
+	//500k particles from the dot sprites
+	const int particleCount = 500000;
+	const int frames = 60;
+	LParticleSystem particles;
+	if (!particles.create(particleCount, gSpriteSheetTexture.getTexture(), gSpriteClips, 4, 4))
+	{
+		return;
+	}
+	particles.setTint(1, 0xFF, 0x80, 0x80);
+	particles.setTint(2, 0x80, 0xFF, 0x80);
+	particles.setTint(3, 0x80, 0x80, 0xFF);
+
+	double freq = (double)SDL_GetPerformanceFrequency();
+	Uint64 updateTicks = 0;
+	Uint64 submitTicks = 0;
+	Uint64 particleFrames = 0;
+	for (int f = 0; f < frames; ++f)
+	{
+		//Keep the pool full so every frame measures the target load
+		particles.emit(SCREEN_WIDTH / 2.0f, SCREEN_HEIGHT / 2.0f, particleCount - particles.getCount(), 300.0f, 4.0f);
+		particleFrames += particles.getCount();
+
+		Uint64 start = SDL_GetPerformanceCounter();
+		particles.update(1.0f / 60.0f);
+		updateTicks += SDL_GetPerformanceCounter() - start;
+
+		gRenderState.setDrawColor(0x00, 0x00, 0x00, 0xFF);
+		renderClear(gRenderer.get());
+		start = SDL_GetPerformanceCounter();
+		particles.render(gRenderer.get());
+		submitTicks += SDL_GetPerformanceCounter() - start;
+		presentFrame();
+	}
+
+	double nsPerTick = 1e9 / freq;
+	printf("Particles: %d per frame, update %.2f ns/particle (%.3f ms/frame), submit %.2f ns/particle (%.3f ms/frame)\n",
+		particleCount, updateTicks * nsPerTick / particleFrames, updateTicks * 1000.0 / freq / frames,
+		submitTicks * nsPerTick / particleFrames, submitTicks * 1000.0 / freq / frames);
 }
+
+void benchmarkAnimations()
+{
+	if (gSpriteSheetTexture.getTexture() == NULL && !loadMedia11())
+	{
+		return;
+	}
+
+	//100k sprites playing the dots sequence at staggered offsets
+	const int spriteCount = 100000;
+	const int frames = 120;
+	int dots = gDotAnimations.find("dots");
+	LAnimator animator;
+	animator.reserve(spriteCount);
+	for (int i = 0; i < spriteCount; ++i)
+	{
+		animator.add(gDotAnimations, dots, i * 7);
+	}
+
+	double freq = (double)SDL_GetPerformanceFrequency();
+	Uint64 updateTicks = 0;
+	Uint64 submitTicks = 0;
+	SDL_Texture* texture = gSpriteSheetTexture.getTexture();
+	const SDL_Rect* clips = gDotAnimations.getClips();
+	for (int f = 0; f < frames; ++f)
+	{
+		Uint64 start = SDL_GetPerformanceCounter();
+		animator.update(gDotAnimations, 16);
+		updateTicks += SDL_GetPerformanceCounter() - start;
+
+		//Draw the sprites on a grid, overlapping the screen many times over
+		gRenderState.setDrawColor(0xFF, 0xFF, 0xFF, 0xFF);
+		renderClear(gRenderer.get());
+		start = SDL_GetPerformanceCounter();
+		for (int i = 0; i < spriteCount; ++i)
+		{
+			SDL_Rect dst = { (i * 16) % SCREEN_WIDTH, (i / (SCREEN_WIDTH / 16) * 16) % SCREEN_HEIGHT, 16, 16 };
+			renderCopy(gRenderer.get(), texture, &clips[animator.getClipIndex(i)], &dst);
+		}
+		submitTicks += SDL_GetPerformanceCounter() - start;
+		presentFrame();
+	}
+
+	double nsPerTick = 1e9 / freq;
+	printf("Animations: %d sprites, update %.2f ns/sprite (%.3f ms/frame), submit %.2f ns/sprite\n",
+		spriteCount, updateTicks * nsPerTick / ((double)spriteCount * frames), updateTicks * 1000.0 / freq / frames,
+		submitTicks * nsPerTick / ((double)spriteCount * frames));
+}
+
+void benchmarkHandles()
+{
+	//Real textures so handle destructors have something to destroy
+	const int textureCount = 1024;
+	const int rounds = 2000;
+	std::vector<LTextureHandle> handles;
+	std::vector<SDL_Texture*> raw;
+	handles.reserve(textureCount);
+	raw.reserve(textureCount);
+	for (int i = 0; i < textureCount; ++i)
+	{
+		handles.push_back(LTextureHandle(SDL_CreateTexture(gRenderer.get(), SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, 1, 1)));
+		raw.push_back(handles.back().get());
+	}
+
+	//Rotate both arrays by moving every element, the handle moves must cost the same as pointer copies
+	double freq = (double)SDL_GetPerformanceFrequency();
+	Uint64 start = SDL_GetPerformanceCounter();
+	for (int r = 0; r < rounds; ++r)
+	{
+		SDL_Texture* first = raw[0];
+		for (int i = 1; i < textureCount; ++i)
+		{
+			raw[i - 1] = raw[i];
+		}
+		raw[textureCount - 1] = first;
+	}
+	Uint64 rawTicks = SDL_GetPerformanceCounter() - start;
+
+	start = SDL_GetPerformanceCounter();
+	for (int r = 0; r < rounds; ++r)
+	{
+		LTextureHandle first = std::move(handles[0]);
+		for (int i = 1; i < textureCount; ++i)
+		{
+			handles[i - 1] = std::move(handles[i]);
+		}
+		handles[textureCount - 1] = std::move(first);
+	}
+	Uint64 handleTicks = SDL_GetPerformanceCounter() - start;
+
+	//LTexture lives in a vector, growth moves instead of copying and double freeing
+	std::vector<LTexture> textures;
+	start = SDL_GetPerformanceCounter();
+	for (int i = 0; i < textureCount; ++i)
+	{
+		textures.push_back(LTexture());
+	}
+	Uint64 vectorTicks = SDL_GetPerformanceCounter() - start;
+
+	double moves = (double)rounds * textureCount;
+	printf("Handles: raw pointer move %.3f ns, handle move %.3f ns, %d LTexture push_backs %.3f ms, handle size %u bytes\n",
+		rawTicks * 1e9 / freq / moves, handleTicks * 1e9 / freq / moves, textureCount, vectorTicks * 1000.0 / freq,
+		(unsigned)sizeof(LTextureHandle));
+}
+
+void benchmarkSurfacePool()
+{
+	const char* assets[] = { "res/background.png", "res/dots.png", "res/full.png", "res/image.png", "res/lession7.png", "res/lession10/foo.png" };
+	const int assetCount = sizeof(assets) / sizeof(assets[0]);
+	const int rounds = 20;
+	Uint32 screenFormat = SDL_GetWindowPixelFormat(gWindow.get());
+	double freq = (double)SDL_GetPerformanceFrequency();
+
+	//Previous path, a fresh converted surface per load
+	size_t rssBefore = LSurfacePool::getPeakResidentBytes();
+	Uint64 start = SDL_GetPerformanceCounter();
+	Uint32 freshAllocations = 0;
+	for (int r = 0; r < rounds; ++r)
+	{
+		for (int i = 0; i < assetCount; ++i)
+		{
+			SDL_Surface* loaded = IMG_Load(assets[i]);
+			if (loaded == NULL)
+			{
+				continue;
+			}
+			SDL_Surface* converted = SDL_ConvertSurfaceFormat(loaded, screenFormat, 0);
+			freshAllocations += converted != NULL;
+			SDL_FreeSurface(converted);
+			SDL_FreeSurface(loaded);
+		}
+	}
+	double freshMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / freq;
+	size_t rssFresh = LSurfacePool::getPeakResidentBytes();
+
+	//Pooled path
+	Uint32 acquiresBefore = gSurfacePool.getAcquireCount();
+	Uint32 allocationsBefore = gSurfacePool.getAllocationCount();
+	start = SDL_GetPerformanceCounter();
+	for (int r = 0; r < rounds; ++r)
+	{
+		for (int i = 0; i < assetCount; ++i)
+		{
+			gSurfacePool.release(loadSurface(assets[i]));
+		}
+	}
+	double pooledMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / freq;
+	size_t rssPooled = LSurfacePool::getPeakResidentBytes();
+
+	printf("Surface pool: unpooled %.2f ms, %u conversion allocations, peak RSS %u -> %u KB\n",
+		freshMs, freshAllocations, (unsigned)(rssBefore / 1024), (unsigned)(rssFresh / 1024));
+	printf("Surface pool: pooled %.2f ms, %u conversions, %u buffer allocations, pool %u KB, peak RSS %u KB\n",
+		pooledMs, gSurfacePool.getAcquireCount() - acquiresBefore, gSurfacePool.getAllocationCount() - allocationsBefore,
+		(unsigned)(gSurfacePool.getPooledBytes() / 1024), (unsigned)(rssPooled / 1024));
+}
+
+void benchmarkProfiler()
+{
+	//Cost of an empty zone, both counter reads and the ring write
+	const int zones = 1000000;
+	double freq = (double)SDL_GetPerformanceFrequency();
+	Uint64 start = SDL_GetPerformanceCounter();
+	for (int i = 0; i < zones; ++i)
+	{
+		LPROFILE_ZONE("empty");
+	}
+	Uint64 ticks = SDL_GetPerformanceCounter() - start;
+	printf("Profiler: %.2f ns per zone\n", ticks * 1e9 / freq / zones);
+}
+
+static void emptyJob(void*)
+{
+}
+
+//Counts the links of a dependency chain that actually ran
+static void chainJob(void* data)
+{
+	SDL_AtomicIncRef((SDL_atomic_t*)data);
+}
+
+void benchmarkJobs()
+{
+	//Submit, run and retire cost of a job that does nothing
+	const int jobs = 100000;
+	double freq = (double)SDL_GetPerformanceFrequency();
+	LJobCounter counter;
+	SDL_AtomicSet(&counter.value, 0);
+	gJobSystem.resetStats();
+	Uint64 start = SDL_GetPerformanceCounter();
+	for (int i = 0; i < jobs; ++i)
+	{
+		gJobSystem.run(emptyJob, NULL, &counter);
+	}
+	gJobSystem.wait(&counter);
+	Uint64 ticks = SDL_GetPerformanceCounter() - start;
+	printf("Jobs: %.3f us per empty job with %d workers, target under 1 us\n", ticks * 1e6 / freq / jobs, gJobSystem.getWorkerCount());
+
+	//Every link waits on the one before, so each is either released by finish() or runs straight away
+	const int links = 10000;
+	std::vector<LJobCounter> chain(links);
+	for (int i = 0; i < links; ++i)
+	{
+		SDL_AtomicSet(&chain[i].value, 0);
+	}
+	SDL_atomic_t ran;
+	SDL_AtomicSet(&ran, 0);
+	start = SDL_GetPerformanceCounter();
+	for (int i = 0; i < links; ++i)
+	{
+		gJobSystem.run(chainJob, &ran, &chain[i], i > 0 ? &chain[i - 1] : NULL);
+	}
+	gJobSystem.wait(&chain[links - 1]);
+	ticks = SDL_GetPerformanceCounter() - start;
+	printf("Jobs: %.3f us per dependent job, %d of %d ran\n", ticks * 1e6 / freq / links, SDL_AtomicGet(&ran), links);
+	gJobSystem.printStats();
+}
+
+//Stands in for a frame's game logic
+static void simulateLogic(double milliseconds)
+{
+	Uint64 end = SDL_GetPerformanceCounter() + (Uint64)(milliseconds * SDL_GetPerformanceFrequency() / 1000.0);
+	while (SDL_GetPerformanceCounter() < end)
+	{
+	}
+}
+
+void benchmarkRenderThread()
+{
+	//Every frame reads input, runs 4 ms of logic and draws lesson 12, first on one thread then on two
+	const int frames = 240;
+	const double logicMs = 4.0;
+	bool wasRunning = gRenderThread.isRunning();
+	stopRenderThread();
+
+	LLatencyStats serial;
+	for (int i = 0; i < frames; ++i)
+	{
+		Uint64 input = SDL_GetPerformanceCounter();
+		simulateLogic(logicMs);
+		DrawLession12(gRenderer.get(), 0xFF, 0xFF, 0xFF);
+		serial.record(input, SDL_GetPerformanceCounter());
+	}
+	serial.print("Render thread off");
+
+	if (!startRenderThread())
+	{
+		return;
+	}
+	for (int i = 0; i < frames; ++i)
+	{
+		Uint64 input = SDL_GetPerformanceCounter();
+		simulateLogic(logicMs);
+		LCommandList& list = gRenderThread.beginFrame();
+		recordLession12(list, 0xFF, 0xFF, 0xFF);
+		gRenderThread.endFrame(input);
+	}
+	gRenderThread.stop();
+	gRenderState.invalidate();
+	gRenderThread.getLatency().print("Render thread on");
+
+	if (wasRunning)
+	{
+		startRenderThread();
+	}
+}
+
+//Keys whose handlers touch the renderer, which only the render thread may use while it runs
+static bool needsRenderer(SDL_Keycode key)
+{
+	switch (key)
+	{
+	case SDLK_2:
+	case SDLK_3:
+	case SDLK_F1:
+	case SDLK_F2:
+	case SDLK_F3:
+	case SDLK_F4:
+	case SDLK_F5:
+	case SDLK_h:
+	case SDLK_r:
+	case SDLK_c:
+		return true;
+	default:
+		return false;
+	}
+}
+
+//The benchmark build links these lessons into its own executable
+#ifndef SDLTEST_NO_MAIN
 int main(int argc, char* argv[]) {
+	//Startup is timed until the first frame reaches the screen
+	gStartupTrace.begin();
+	{
+		LSTARTUP_PHASE("LJobSystem::start");
+		gJobSystem.start(SDL_GetCPUCount() - 1);
+	}
+
+	//Assets come from res.pak once it has been packed, loose files otherwise
+	{
+		LSTARTUP_PHASE("LAssetArchive::open");
+		gAssetArchive.open("res.pak");
+	}
+
+	//--serial-init keeps the old init then load order to compare startup times against
+	//--lazy decodes each image on its first draw instead of at load
+	//--upload-budget spreads texture uploads over frames
+	//--tiles FILE picks the tiled image shown with 3
+	bool serialInit = false;
+	for (int i = 1; i < argc; ++i) {
+		if (SDL_strcmp(argv[i], "--serial-init") == 0) {
+			serialInit = true;
+		}
+		else if (SDL_strcmp(argv[i], "--lazy") == 0) {
+			LTexture::setLazy(true);
+		}
+		else if (SDL_strcmp(argv[i], "--upload-budget") == 0) {
+			gUploadScheduler.setBudget(LUploadScheduler::DEFAULT_BYTES, LUploadScheduler::DEFAULT_MICROSECONDS);
+		}
+		else if (SDL_strcmp(argv[i], "--tiles") == 0 && i + 1 < argc) {
+			gTiledPath = argv[++i];
+		}
+	}
 
 	bool quit = false;
 
-	quit = !init();
-	quit = !loadMedia();
+	if (serialInit) {
+		quit = !init();
+		quit = !loadMedia();
+	}
+	else {
+		quit = !initParallel();
+	}
+
+	//Edited images show up while running
+	if (!quit) {
+		gAssetWatcher.start();
+	}
 
 	SDL_Event e;
 	int clickNum = 0;
 	
 
+	//Show the stretched image instead of the modulation lesson
+	bool showStretch = false;
+
+	//Show the tiled image viewer instead
+	bool showTiles = false;
+
 	//Modulation components
 	Uint8 r = 255;
 	Uint8 g = 255;
@@ -467,67 +1248,194 @@ int main(int argc, char* argv[]) {
 
 	while (!quit) {
 
-		while (SDL_PollEvent(&e))
 		{
-			if (e.type == SDL_QUIT)
-			{
-				quit = true;
-			}
-			if (e.type == SDL_KEYDOWN)
+			LPROFILE_ZONE("SDL_PollEvent");
+
+			while (SDL_PollEvent(&e))
 			{
-				switch (e.key.keysym.sym)
+				if (e.type == SDL_QUIT)
+				{
+					quit = true;
+				}
+				if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+				{
+					//Scaled images no longer match the window, and SDL resets the viewport to cover it
+					gScaledCache.clear();
+					gRenderState.invalidate();
+				}
+				if ((e.type == SDL_KEYDOWN || e.type == SDL_MOUSEBUTTONDOWN) && gInputTime == 0)
+				{
+					gInputTime = SDL_GetPerformanceCounter();
+				}
+				if (e.type == SDL_KEYDOWN)
+				{
+					if (needsRenderer(e.key.keysym.sym))
+					{
+						stopRenderThread();
+					}
+
+					switch (e.key.keysym.sym)
+					{
+						//Increase red
+					case SDLK_q:
+						r += 32;
+						break;
+
+						//Increase green
+					case SDLK_w:
+						g += 32;
+						break;
+
+						//Increase blue
+					case SDLK_e:
+						b += 32;
+						break;
+
+						//Decrease red
+					case SDLK_a:
+						r -= 32;
+						break;
+
+						//Decrease green
+					case SDLK_s:
+						g -= 32;
+						break;
+
+						//Decrease blue
+					case SDLK_d:
+						b -= 32;
+						break;
+
+					case SDLK_1:
+						/*DrawLession11();
+						gSpriteSheetTexture.render(gRenderer.get(), SCREEN_WIDTH / 2 - gSpriteClips[1].w / 2, SCREEN_HEIGHT / 2 - gSpriteClips[1].h / 2, &gSpriteClips[clickNum % 4]);
+						SDL_RenderPresent(gRenderer.get());
+						clickNum++;*/
+						break;
+					case SDLK_2:
+						showStretch = !showStretch && (gStretchBitmap.getSurface() != NULL || loadMediaStretch());
+						showTiles = showTiles && !showStretch;
+						break;
+					case SDLK_3:
+						showTiles = !showTiles && (gTiledImage.isOpen() || gTiledImage.open(gTiledPath));
+						showStretch = showStretch && !showTiles;
+						break;
+					case SDLK_F1:
+						benchmarkCommandLists();
+						break;
+					case SDLK_F2:
+						benchmarkParticles();
+						break;
+					case SDLK_F3:
+						benchmarkAnimations();
+						break;
+					case SDLK_F4:
+						benchmarkHandles();
+						break;
+					case SDLK_F5:
+						benchmarkSurfacePool();
+						break;
+					case SDLK_F6:
+						benchmarkProfiler();
+						break;
+					case SDLK_F7:
+						benchmarkJobs();
+						break;
+					case SDLK_F8:
+						benchmarkRenderThread();
+						break;
+					case SDLK_t:
+						//Record on this thread, render and present on another
+						if (gRenderThread.isRunning())
+						{
+							stopRenderThread();
+						}
+						else
+						{
+							showStretch = false;
+							showTiles = false;
+							startRenderThread();
+						}
+						break;
+					case SDLK_l:
+						gSerialLatency.print("Render thread off");
+						gRenderThread.getLatency().print("Render thread on");
+						gSerialLatency.reset();
+						break;
+					case SDLK_j:
+						gJobSystem.printStats();
+						gJobSystem.resetStats();
+						break;
+					case SDLK_m:
+						gMemoryTracker.printReport();
+						break;
+					case SDLK_p:
+						//Trace the next two seconds
+						gProfiler.captureFrames("trace.json", 120);
+						break;
+					case SDLK_h:
+						//Performance overlay, built on first use
+						if (gHud.isVisible() || gHud.create(gRenderer.get(), gAssetPreloader.openFile("sample.ttf"), 14))
+						{
+							gHud.toggle();
+						}
+						gRenderStats.setEnabled(gHud.isVisible() || gRenderStats.isLogging());
+						break;
+					case SDLK_r:
+						//Per frame render call counts to CSV
+						if (gRenderStats.isLogging())
+						{
+							gRenderStats.stopCsv();
+						}
+						else
+						{
+							gRenderStats.startCsv("renderstats.csv");
+						}
+						gRenderStats.setEnabled(gHud.isVisible() || gRenderStats.isLogging());
+						break;
+					case SDLK_c:
+						//Toggle gameplay recording
+						if (gFrameCapture.isCapturing())
+						{
+							gFrameCapture.stop();
+							gFrameCapture.printStats();
+						}
+						else
+						{
+							gFrameCapture.start(gRenderer.get(), "capture.y4m");
+						}
+						break;
+					case SDLK_ESCAPE:
+						quit = true;
+						break;
+					default:
+						break;
+					}
+				}
+				if (e.type == SDL_MOUSEBUTTONDOWN)
 				{
-					//Increase red
-				case SDLK_q:
-					r += 32;
-					break;
-
-					//Increase green
-				case SDLK_w:
-					g += 32;
-					break;
-
-					//Increase blue
-				case SDLK_e:
-					b += 32;
-					break;
-
-					//Decrease red
-				case SDLK_a:
-					r -= 32;
-					break;
-
-					//Decrease green
-				case SDLK_s:
-					g -= 32;
-					break;
-
-					//Decrease blue
-				case SDLK_d:
-					b -= 32;
-					break;
-
-				case SDLK_1:
-					/*DrawLession11();
-					gSpriteSheetTexture.render(gRenderer, SCREEN_WIDTH / 2 - gSpriteClips[1].w / 2, SCREEN_HEIGHT / 2 - gSpriteClips[1].h / 2, &gSpriteClips[clickNum % 4]);
-					SDL_RenderPresent(gRenderer);
-					clickNum++;*/
-					break;
-				case SDLK_ESCAPE:
 					quit = true;
-					break;
-				default:
-					break;
 				}
-			}
-			if (e.type == SDL_MOUSEBUTTONDOWN)
-			{
-				quit = true;
-			}
 
+			}
 		}
 
-		DrawLession12(gRenderer,r,g,b);
+		if (gRenderThread.isRunning())
+		{
+			submitLession12(r, g, b);
+		}
+		else if (showStretch)
+		{
+			DrawStretch();
+		}
+		else if (showTiles)
+		{
+			DrawTiles();
+		}
+		else
+		{
+			DrawLession12(gRenderer.get(), r, g, b);
+		}
 		
 		//DrawLession8();
 		//DrawLession9();
@@ -537,17 +1445,45 @@ int main(int argc, char* argv[]) {
 	close();
 	return 0;
 }
+#endif
 
 void close()
 {
+	//Flush any recording in progress
+	if (gFrameCapture.isCapturing())
+	{
+		gFrameCapture.stop();
+		gFrameCapture.printStats();
+	}
+	//Hand the renderer back before anything is freed
+	stopRenderThread();
+	gRenderStats.stopCsv();
+
 	//Free loaded images
+	gScaledCache.clear();
+	gStretchBitmap.free();
+	gTiledImage.close();
 	gFooTexture.free();
 	gBackgroundTexture.free();
-
-	cleanup(gTexture, gWindow, gRenderer);
-	gTexture = NULL;
-	gWindow = NULL;
-	gRenderer = NULL;
+	gSpriteSheetTexture.free();
+	gModulatedTexture.free();
+	gTexture.reset();
+	gHud.free();
+	gAssetPreloader.free();
+	gAssetWatcher.stop();
+	gUploadScheduler.clear();
+	gJobSystem.stop();
+
+	//Nothing streams from the archive anymore
+	gAssetArchive.close();
+	gSurfacePool.trim();
+
+	//Anything still tracked was never freed
+	gMemoryTracker.reportLeaks();
+
+	//Renderer goes before the window it draws to
+	gRenderer.reset();
+	gWindow.reset();
 
 	//Quit SDL subsystems
 	IMG_Quit();
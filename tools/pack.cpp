@@ -0,0 +1,115 @@
+// Packs loose assets into one archive for LAssetArchive
+// Directories are walked recursively, entries keep the paths as given so
+// "sdlPack res.pak res sample.ttf" run from sdlTest/ serves "res/dots.png".
+
+#include "SDL.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include"LAssetArchive.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+//Appends path, or every file below it when it is a directory
+static bool collect(const std::string& path, std::vector<std::string>& files)
+{
+#if defined(_WIN32)
+	DWORD attributes = GetFileAttributesA(path.c_str());
+	if (attributes == INVALID_FILE_ATTRIBUTES)
+	{
+		printf("Unable to find %s\n", path.c_str());
+		return false;
+	}
+	if ((attributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+	{
+		files.push_back(path);
+		return true;
+	}
+
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((path + "/*").c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE)
+	{
+		return true;
+	}
+	bool success = true;
+	do
+	{
+		if (SDL_strcmp(data.cFileName, ".") != 0 && SDL_strcmp(data.cFileName, "..") != 0)
+		{
+			success = collect(path + "/" + data.cFileName, files) && success;
+		}
+	} while (FindNextFileA(find, &data));
+	FindClose(find);
+	return success;
+#else
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+	{
+		printf("Unable to find %s\n", path.c_str());
+		return false;
+	}
+	if (!S_ISDIR(info.st_mode))
+	{
+		files.push_back(path);
+		return true;
+	}
+
+	DIR* dir = opendir(path.c_str());
+	if (dir == NULL)
+	{
+		printf("Unable to open directory %s\n", path.c_str());
+		return false;
+	}
+	bool success = true;
+	while (struct dirent* entry = readdir(dir))
+	{
+		if (SDL_strcmp(entry->d_name, ".") != 0 && SDL_strcmp(entry->d_name, "..") != 0)
+		{
+			success = collect(path + "/" + entry->d_name, files) && success;
+		}
+	}
+	closedir(dir);
+	return success;
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		printf("Usage: %s ARCHIVE FILE_OR_DIRECTORY...\n", argv[0]);
+		return 2;
+	}
+
+	std::vector<std::string> files;
+	for (int i = 2; i < argc; ++i)
+	{
+		std::string path = argv[i];
+		while (path.size() > 1 && (path.back() == '/' || path.back() == '\\'))
+		{
+			path.pop_back();
+		}
+		if (!collect(path, files))
+		{
+			return 1;
+		}
+	}
+
+	//Directory order differs between systems, the archive should not
+	std::sort(files.begin(), files.end());
+	files.erase(std::unique(files.begin(), files.end()), files.end());
+
+	if (!LAssetArchive::pack(argv[1], files))
+	{
+		return 1;
+	}
+	printf("Packed %u files into %s\n", (unsigned)files.size(), argv[1]);
+	return 0;
+}
@@ -0,0 +1,112 @@
+// Splits a large image into an LTiledImage file with its pyramid levels
+// "sdlTiles big.til photo.bmp" tiles an image on disk, uncompressed BMPs are mapped
+// rather than decoded, so only the tiles being encoded are in memory as ARGB8888.
+// "sdlTiles big.til --synthetic 32768 32768" writes a generated test pattern instead.
+
+#include "SDL.h"
+#include "SDL_image.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include"LTiledImage.h"
+#include"LBitmap.h"
+
+//Gradient with a checkerboard and a grid every 1024 pixels, so panning and level changes show
+static void syntheticSource(int x, int y, int w, int h, Uint32* pixels, int pitch, void*)
+{
+	for (int row = 0; row < h; ++row)
+	{
+		int py = y + row;
+		for (int column = 0; column < w; ++column)
+		{
+			int px = x + column;
+			Uint32 red = (Uint32)(px >> 7) & 0xFF;
+			Uint32 green = (Uint32)(py >> 7) & 0xFF;
+			Uint32 blue = ((px >> 5) ^ (py >> 5)) & 1 ? 0xC0 : 0x40;
+			if ((px & 1023) < 4 || (py & 1023) < 4)
+			{
+				red = green = blue = 0xFF;
+			}
+			pixels[row * pitch + column] = 0xFF000000 | (red << 16) | (green << 8) | blue;
+		}
+	}
+}
+
+//Copies a block out of the source surface, converting as it goes
+static void surfaceSource(int x, int y, int w, int h, Uint32* pixels, int pitch, void* userdata)
+{
+	SDL_Surface* surface = (SDL_Surface*)userdata;
+	const Uint8* src = (const Uint8*)surface->pixels + (size_t)y * surface->pitch + (size_t)x * surface->format->BytesPerPixel;
+	SDL_ConvertPixels(w, h, surface->format->format, src, surface->pitch, SDL_PIXELFORMAT_ARGB8888, pixels, pitch * 4);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3 || (SDL_strcmp(argv[2], "--synthetic") == 0 && argc < 5))
+	{
+		printf("Usage: %s OUTPUT (IMAGE | --synthetic WIDTH HEIGHT)\n", argv[0]);
+		return 2;
+	}
+	if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG))
+	{
+		printf("SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError());
+		return 1;
+	}
+	gJobSystem.start(SDL_GetCPUCount() - 1);
+
+	bool success = false;
+	int width = 0;
+	int height = 0;
+	if (SDL_strcmp(argv[2], "--synthetic") == 0)
+	{
+		width = atoi(argv[3]);
+		height = atoi(argv[4]);
+		success = LTiledImage::build(argv[1], width, height, syntheticSource, NULL);
+	}
+	else
+	{
+		//BMPs are mapped, everything else has to be decoded whole
+		std::string path = argv[2];
+		LBitmap bitmap;
+		SDL_Surface* loaded = NULL;
+		SDL_Surface* source = NULL;
+		if (path.size() > 4 && SDL_strcasecmp(path.c_str() + path.size() - 4, ".bmp") == 0 && bitmap.loadFromFile(path))
+		{
+			source = bitmap.getSurface();
+		}
+		else
+		{
+			loaded = IMG_Load(path.c_str());
+			source = loaded;
+			if (loaded == NULL)
+			{
+				printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+			}
+		}
+
+		//Palettes have no SDL_ConvertPixels path
+		if (source != NULL && source->format->BytesPerPixel == 1)
+		{
+			SDL_Surface* converted = SDL_ConvertSurfaceFormat(source, SDL_PIXELFORMAT_ARGB8888, 0);
+			SDL_FreeSurface(loaded);
+			loaded = converted;
+			source = converted;
+		}
+		if (source != NULL)
+		{
+			width = source->w;
+			height = source->h;
+			success = LTiledImage::build(argv[1], width, height, surfaceSource, source);
+		}
+		SDL_FreeSurface(loaded);
+	}
+
+	gJobSystem.stop();
+	IMG_Quit();
+	if (!success)
+	{
+		return 1;
+	}
+	printf("Tiled %dx%d image into %s\n", width, height, argv[1]);
+	return 0;
+}